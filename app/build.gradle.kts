@@ -42,6 +42,10 @@ android {
     buildFeatures {
         viewBinding = true
     }
+    androidResources {
+        // Stored uncompressed so native code can mmap shader assets in place.
+        noCompress += listOf("glslv", "glslf")
+    }
 }
 
 dependencies {
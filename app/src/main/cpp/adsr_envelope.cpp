@@ -0,0 +1,62 @@
+#include "adsr_envelope.h"
+
+#include <algorithm>
+#include <cmath>
+
+void AdsrEnvelope::setSampleRate(float sampleRate) {
+    rate = sampleRate;
+    current = ENVELOPE_IDLE;
+    value = 0.0f;
+    update();
+}
+
+void AdsrEnvelope::setParams(const AdsrParams &values) {
+    params = values;
+    params.sustainLevel = std::clamp(params.sustainLevel, 0.0f, 1.0f);
+    update();
+}
+
+void AdsrEnvelope::update() {
+    attackPerFrame = 1.0f / std::max(params.attackSeconds * rate, 1.0f);
+    decayPerFrame = -1.0f / std::max(params.decaySeconds * rate, 1.0f);
+    releasePerFrame = std::log(ENVELOPE_SILENT_LEVEL) / std::max(params.releaseSeconds * rate, 1.0f);
+}
+
+void AdsrEnvelope::gate(bool on) {
+    if (on) {
+        current = ENVELOPE_ATTACK;
+    } else if (current != ENVELOPE_IDLE) {
+        current = ENVELOPE_RELEASE;
+    }
+}
+
+float AdsrEnvelope::advance(int frames) {
+    float remaining = float(frames);
+    if (current == ENVELOPE_ATTACK) {
+        float needed = (1.0f - value) / attackPerFrame;
+        if (needed > remaining) {
+            value += remaining * attackPerFrame;
+            return value;
+        }
+        value = 1.0f;
+        remaining -= needed;
+        current = ENVELOPE_DECAY;
+    }
+    if (current == ENVELOPE_DECAY) {
+        // Exponential approach to the sustain level; close enough counts as there.
+        value = params.sustainLevel + (value - params.sustainLevel) * std::exp(decayPerFrame * remaining);
+        if (std::fabs(value - params.sustainLevel) < ENVELOPE_SILENT_LEVEL) {
+            // An inaudible sustain ends the note, even with the gate held.
+            const bool silent = params.sustainLevel <= ENVELOPE_SILENT_LEVEL;
+            value = silent ? 0.0f : params.sustainLevel;
+            current = silent ? ENVELOPE_IDLE : ENVELOPE_SUSTAIN;
+        }
+    } else if (current == ENVELOPE_RELEASE) {
+        value *= std::exp(releasePerFrame * remaining);
+        if (value < ENVELOPE_SILENT_LEVEL) {
+            value = 0.0f;
+            current = ENVELOPE_IDLE;
+        }
+    }
+    return value;
+}
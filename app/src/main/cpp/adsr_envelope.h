@@ -0,0 +1,60 @@
+#pragma once
+
+const int ENVELOPE_IDLE = 0;
+const int ENVELOPE_ATTACK = 1;
+const int ENVELOPE_DECAY = 2;
+const int ENVELOPE_SUSTAIN = 3;
+const int ENVELOPE_RELEASE = 4;
+
+const float ENVELOPE_SILENT_LEVEL = 1e-4f; // release, or decay to a sustain this low, ends (idle)
+
+struct AdsrParams {
+    float attackSeconds = 0.01f;   // linear rise to 1
+    float decaySeconds = 0.15f;    // exponential fall to sustainLevel (time constant)
+    float sustainLevel = 0.7f;
+    float releaseSeconds = 0.4f;   // exponential fall to ENVELOPE_SILENT_LEVEL
+};
+
+/*
+ * AdsrEnvelope
+ *    Attack / decay / sustain / release level for a gated sound, advanced
+ *    a block at a time: advance() returns the level at the end of the
+ *    block and callers ramp linearly to it, which is indistinguishable
+ *    from per-sample evaluation at DSP_BLOCK_FRAMES for segments of a few
+ *    milliseconds or more and keeps the envelope off the per-sample path.
+ *    gate(true) while already sounding re-attacks from the current level.
+ *    With sustainLevel at or below ENVELOPE_SILENT_LEVEL it is a
+ *    percussive envelope: idle at the end of the decay, gate held or not.
+ *    Audio thread only, except setSampleRate() / setParams() while the
+ *    device is stopped.
+ */
+class AdsrEnvelope {
+public:
+    // Also resets to idle.
+    void setSampleRate(float sampleRate);
+
+    void setParams(const AdsrParams &params);
+
+    void gate(bool on);
+
+    // Advances by frames and returns the new level.
+    float advance(int frames);
+
+    float level() const { return value; }
+
+    int stage() const { return current; }
+
+    bool idle() const { return current == ENVELOPE_IDLE; }
+
+private:
+    void update();
+
+    float rate = 48000.0f;
+    AdsrParams params;
+    float attackPerFrame = 1.0f;
+    float decayPerFrame = 0.0f;    // log of the per-frame factor
+    float releasePerFrame = 0.0f;  // ditto
+
+    int current = ENVELOPE_IDLE;
+    float value = 0.0f;
+};
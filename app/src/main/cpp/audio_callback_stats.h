@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+ * AudioCallbackStats
+ *    Timing of the audio callback, recorded from inside it. The callback
+ *    reads the clock once on entry and once on exit and hands both to
+ *    record(), which derives the time since the previous callback, the
+ *    load (elapsed time over the buffer's duration) and late / missed
+ *    callbacks. Counters and the load histogram have a single writer, so
+ *    they are updated with relaxed loads and stores rather than atomic
+ *    read-modify-writes; any thread may take a snapshot().
+ *
+ *    A callback is late when it starts more than LATE_FACTOR buffer periods
+ *    after the previous one; every further whole period of the gap counts
+ *    as a missed callback.
+ */
+class AudioCallbackStats {
+public:
+    static constexpr int LOAD_BUCKET_PERCENT = 5;
+    static constexpr int LOAD_BUCKETS = 41; // last bucket is >= 200 %
+    static constexpr double LATE_FACTOR = 1.5;
+
+    struct Snapshot {
+        uint64_t callbacks = 0;
+        uint64_t frames = 0;
+        uint64_t late = 0;
+        uint64_t missed = 0;
+        uint64_t elapsedNs = 0; // time spent in the callback
+        uint64_t periodNs = 0;  // audio produced, as time
+        uint64_t maxElapsedNs = 0;
+        uint64_t intervals = 0;  // callbacks with a measured predecessor
+        uint64_t intervalNs = 0; // summed start-to-start time
+        uint64_t loadHistogram[LOAD_BUCKETS] = {};
+
+        double meanLoadPercent() const {
+            return periodNs ? 100.0 * double(elapsedNs) / double(periodNs) : 0.0;
+        }
+
+        double meanIntervalUs() const {
+            return intervals ? double(intervalNs) / double(intervals) / 1000.0 : 0.0;
+        }
+
+        // Upper edge of the histogram bucket holding quantile q (0..1).
+        int loadPercentile(double q) const {
+            uint64_t target = uint64_t(q * double(callbacks));
+            uint64_t seen = 0;
+            for (int b = 0; b < LOAD_BUCKETS; b++) {
+                seen += loadHistogram[b];
+                if (seen > target) return (b + 1) * LOAD_BUCKET_PERCENT;
+            }
+            return LOAD_BUCKETS * LOAD_BUCKET_PERCENT;
+        }
+
+        // Counts accumulated since an earlier snapshot; max stays lifetime.
+        Snapshot since(const Snapshot &earlier) const {
+            Snapshot d = *this;
+            d.callbacks -= earlier.callbacks;
+            d.frames -= earlier.frames;
+            d.late -= earlier.late;
+            d.missed -= earlier.missed;
+            d.elapsedNs -= earlier.elapsedNs;
+            d.periodNs -= earlier.periodNs;
+            d.intervals -= earlier.intervals;
+            d.intervalNs -= earlier.intervalNs;
+            for (int b = 0; b < LOAD_BUCKETS; b++) d.loadHistogram[b] -= earlier.loadHistogram[b];
+            return d;
+        }
+    };
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Forget the previous callback so a stop/start gap is not counted as
+    // missed callbacks. Only while the device is stopped.
+    void restart() { previousStartNs = 0; }
+
+    // Audio thread only.
+    void record(int64_t startNs, int64_t endNs, uint32_t frameCount, uint32_t sampleRate) {
+        const int64_t periodNs = int64_t(frameCount) * 1000000000 / int64_t(sampleRate);
+        const int64_t elapsedNs = endNs - startNs;
+        if (previousStartNs != 0 && periodNs > 0) {
+            const int64_t intervalNs = startNs - previousStartNs;
+            bump(intervals, 1);
+            bump(totalIntervalNs, uint64_t(intervalNs));
+            if (double(intervalNs) > LATE_FACTOR * double(periodNs)) {
+                bump(late, 1);
+                bump(missed, uint64_t(intervalNs / periodNs - 1));
+            }
+        }
+        previousStartNs = startNs;
+
+        bump(callbacks, 1);
+        bump(frames, frameCount);
+        bump(totalElapsedNs, uint64_t(elapsedNs));
+        bump(totalPeriodNs, uint64_t(periodNs));
+        if (uint64_t(elapsedNs) > maxElapsedNs.load(std::memory_order_relaxed)) {
+            maxElapsedNs.store(uint64_t(elapsedNs), std::memory_order_relaxed);
+        }
+        int bucket = periodNs > 0 ? int(elapsedNs * 100 / (periodNs * LOAD_BUCKET_PERCENT)) : 0;
+        bump(loadHistogram[bucket < LOAD_BUCKETS ? bucket : LOAD_BUCKETS - 1], 1);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.callbacks = callbacks.load(std::memory_order_relaxed);
+        s.frames = frames.load(std::memory_order_relaxed);
+        s.late = late.load(std::memory_order_relaxed);
+        s.missed = missed.load(std::memory_order_relaxed);
+        s.elapsedNs = totalElapsedNs.load(std::memory_order_relaxed);
+        s.periodNs = totalPeriodNs.load(std::memory_order_relaxed);
+        s.maxElapsedNs = maxElapsedNs.load(std::memory_order_relaxed);
+        s.intervals = intervals.load(std::memory_order_relaxed);
+        s.intervalNs = totalIntervalNs.load(std::memory_order_relaxed);
+        for (int b = 0; b < LOAD_BUCKETS; b++) {
+            s.loadHistogram[b] = loadHistogram[b].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t> &counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> callbacks{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> late{0};
+    std::atomic<uint64_t> missed{0};
+    std::atomic<uint64_t> totalElapsedNs{0};
+    std::atomic<uint64_t> totalPeriodNs{0};
+    std::atomic<uint64_t> maxElapsedNs{0};
+    std::atomic<uint64_t> intervals{0};
+    std::atomic<uint64_t> totalIntervalNs{0};
+    std::atomic<uint64_t> loadHistogram[LOAD_BUCKETS] = {};
+    int64_t previousStartNs = 0; // audio thread only
+};
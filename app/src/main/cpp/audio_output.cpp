@@ -0,0 +1,195 @@
+#include "audio_output.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "logging.h"
+#include "rt_safety.h"
+#include "trace_events.h"
+
+namespace {
+
+struct LatencyProfile {
+    const char *name;
+    ma_performance_profile performance;
+    uint32_t burstsPerPeriod;    // period = bursts * native frames per buffer
+    uint32_t periodMilliseconds; // used when the burst size is unknown
+    uint32_t periods;
+    ma_share_mode shareMode;
+};
+
+const LatencyProfile LATENCY_PROFILES[LATENCY_PROFILE_COUNT] = {
+        {"ultra-low", ma_performance_profile_low_latency, 1, 4, 2, ma_share_mode_exclusive},
+        {"balanced", ma_performance_profile_low_latency, 2, 10, 2, ma_share_mode_shared},
+        {"power-saving", ma_performance_profile_conservative, 8, 40, 3, ma_share_mode_shared},
+};
+
+} // namespace
+
+bool AudioOutput::open(RenderCallback renderCallback, void *user,
+                       const ma_backend *backends, uint32_t backendCount) {
+    if (contextInitialized) return true;
+    if (ma_context_init(backends, backendCount, nullptr, &context) != MA_SUCCESS) {
+        LOGI("audio: failed to initialize the audio context");
+        return false;
+    }
+    contextInitialized = true;
+    render = renderCallback;
+    renderUser = user;
+    return true;
+}
+
+void AudioOutput::close() {
+    if (deviceInitialized) {
+        ma_device_uninit(&device);
+        deviceInitialized = false;
+    }
+    if (contextInitialized) {
+        ma_context_uninit(&context);
+        contextInitialized = false;
+    }
+}
+
+void AudioOutput::setNativeParams(int sampleRate, int framesPerBuffer) {
+    nativeSampleRate = std::max(sampleRate, 0);
+    nativeFramesPerBuffer = std::max(framesPerBuffer, 0);
+}
+
+bool AudioOutput::configure(int profile) {
+    if (!contextInitialized) return false;
+    profile = std::clamp(profile, 0, LATENCY_PROFILE_COUNT - 1);
+    const LatencyProfile &latency = LATENCY_PROFILES[profile];
+    const auto openStart = std::chrono::steady_clock::now();
+    if (deviceInitialized) {
+        ma_device_uninit(&device);
+        deviceInitialized = false;
+    }
+
+    // Ask for the output's own rate, format and burst size so miniaudio
+    // doesn't resample or convert on every callback. AAudio reports its
+    // native format when none is requested; OpenSL ES falls back to f32,
+    // which the callback writes directly.
+    ma_device_config config = ma_device_config_init(ma_device_type_playback);
+    config.playback.format = ma_format_unknown;
+    config.playback.channels = AUDIO_OUTPUT_CHANNELS;
+    config.playback.shareMode = latency.shareMode;
+    config.sampleRate = ma_uint32(nativeSampleRate);
+    config.performanceProfile = latency.performance;
+    if (nativeFramesPerBuffer > 0) {
+        config.periodSizeInFrames = latency.burstsPerPeriod * ma_uint32(nativeFramesPerBuffer);
+    } else {
+        config.periodSizeInMilliseconds = latency.periodMilliseconds;
+    }
+    config.periods = latency.periods;
+    // Bursts are passed straight to the callback instead of being
+    // re-blocked into fixed periods through another buffer.
+    config.noFixedSizedCallback = MA_TRUE;
+    // Without this AAudio ignores the period size and count.
+    config.aaudio.allowSetBufferCapacity = MA_TRUE;
+    config.dataCallback = dataCallback;
+    config.pUserData = this;
+
+    ma_result result = ma_device_init(&context, &config, &device);
+    if (result != MA_SUCCESS && config.playback.shareMode == ma_share_mode_exclusive) {
+        config.playback.shareMode = ma_share_mode_shared;
+        result = ma_device_init(&context, &config, &device);
+    }
+    if (result != MA_SUCCESS) {
+        LOGI("audio: failed to open a %s device (%s)", latency.name, ma_result_description(result));
+        return false;
+    }
+    deviceInitialized = true;
+
+    const ma_data_converter &converter = device.playback.converter;
+    Info negotiated;
+    negotiated.profile = profile;
+    negotiated.sampleRate = device.sampleRate;
+    negotiated.periodFrames = device.playback.internalPeriodSizeInFrames;
+    negotiated.periods = device.playback.internalPeriods;
+    negotiated.exclusive = device.playback.shareMode == ma_share_mode_exclusive;
+    negotiated.conversion = (converter.hasResampler ? AUDIO_CONVERSION_RESAMPLE : 0) |
+                            (converter.hasPreFormatConversion || converter.hasPostFormatConversion
+                             ? AUDIO_CONVERSION_FORMAT : 0) |
+                            (converter.hasChannelConverter ? AUDIO_CONVERSION_CHANNELS : 0) |
+                            (device.playback.format != ma_format_f32
+                             ? AUDIO_CONVERSION_CALLBACK_FORMAT : 0);
+    negotiated.openMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - openStart).count();
+    publish(negotiated);
+
+    LOGI("audio: %s profile on %s, %s %u Hz %u ch, period %u x %u frames (%.1f ms), %s, "
+         "native %d Hz %d frames/buffer, device %s %u Hz %u ch, conversion flags %d, "
+         "opened in %.1f ms",
+         latency.name, ma_get_backend_name(context.backend),
+         ma_get_format_name(device.playback.format), device.sampleRate, device.playback.channels,
+         negotiated.periods, negotiated.periodFrames,
+         1000.0 * negotiated.periodFrames / std::max(negotiated.sampleRate, 1u),
+         negotiated.exclusive ? "exclusive" : "shared", nativeSampleRate, nativeFramesPerBuffer,
+         ma_get_format_name(device.playback.internalFormat), device.playback.internalSampleRate,
+         device.playback.internalChannels, negotiated.conversion, negotiated.openMs);
+    return true;
+}
+
+// Control thread only; the sequence is odd while current is rewritten.
+void AudioOutput::publish(const Info &info) {
+    const uint32_t sequence = infoSequence.load(std::memory_order_relaxed);
+    infoSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    current = info;
+    infoSequence.store(sequence + 2, std::memory_order_release);
+}
+
+AudioOutput::Info AudioOutput::info() const {
+    for (;;) {
+        const uint32_t sequence = infoSequence.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+        Info copy = current;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (infoSequence.load(std::memory_order_relaxed) == sequence) return copy;
+    }
+}
+
+bool AudioOutput::start() {
+    if (!deviceInitialized) return false;
+    callbackStats.restart();
+    blocks.reset();
+    if (ma_device_start(&device) != MA_SUCCESS) {
+        LOGI("audio: failed to start the device");
+        return false;
+    }
+    return true;
+}
+
+void AudioOutput::stop() {
+    if (deviceInitialized) ma_device_stop(&device);
+}
+
+void AudioOutput::dataCallback(ma_device *device, void *output, const void *input,
+                               ma_uint32 frameCount) {
+    RT_SAFETY_SCOPE();
+    const int64_t startNs = AudioCallbackStats::now();
+    TRACE_THREAD_NAME("audio");
+    TRACE_SCOPE("data_callback");
+    TRACE_COUNTER("callback frames", frameCount);
+    AudioOutput *self = (AudioOutput *) device->pUserData;
+    const ma_format format = device->playback.format;
+    const uint32_t channels = device->playback.channels;
+    if (format == ma_format_f32) {
+        self->blocks.read((float *) output, frameCount, self->render, self->renderUser);
+    } else {
+        // Render float in chunks and convert once here instead of through
+        // miniaudio's converter.
+        const uint32_t bytesPerFrame = ma_get_bytes_per_frame(format, channels);
+        for (uint32_t done = 0; done < frameCount;) {
+            uint32_t chunk = std::min(frameCount - done, uint32_t(RENDER_CHUNK_FRAMES));
+            self->blocks.read(self->renderBuffer, chunk, self->render, self->renderUser);
+            ma_pcm_convert((uint8_t *) output + done * bytesPerFrame, format,
+                           self->renderBuffer, ma_format_f32, chunk * channels,
+                           ma_dither_mode_none);
+            done += chunk;
+        }
+    }
+    self->callbackStats.record(startNs, AudioCallbackStats::now(), frameCount,
+                               device->sampleRate);
+    (void) input;
+}
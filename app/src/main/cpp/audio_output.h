@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "audio_callback_stats.h"
+#include "block_adapter.h"
+#include "miniaudio.h"
+
+const int AUDIO_OUTPUT_CHANNELS = 2;
+const int RENDER_CHUNK_FRAMES = 1024; // float render buffer for non-f32 devices
+
+// Latency profiles for AudioOutput::configure().
+const int LATENCY_PROFILE_ULTRA_LOW = 0;    // one burst per period, exclusive stream
+const int LATENCY_PROFILE_BALANCED = 1;     // two bursts per period, shared stream
+const int LATENCY_PROFILE_POWER_SAVING = 2; // large periods, fewer wake-ups
+const int LATENCY_PROFILE_COUNT = 3;
+
+// Conversion flags in AudioOutput::Info.
+const int AUDIO_CONVERSION_RESAMPLE = 1;        // miniaudio resamples every callback
+const int AUDIO_CONVERSION_FORMAT = 2;          // miniaudio converts the sample format
+const int AUDIO_CONVERSION_CHANNELS = 4;        // miniaudio converts the channel count
+const int AUDIO_CONVERSION_CALLBACK_FORMAT = 8; // the callback converts float to the device format
+
+/*
+ * AudioOutput
+ *    The playback device. The miniaudio context is created once by open();
+ *    configure() (re)creates only the device for a latency profile, so
+ *    switching profiles costs a stream open rather than a backend probe.
+ *    The device runs at the output's native rate, burst size and format
+ *    (from setNativeParams(), or the backend's own when unknown). The
+ *    render callback always produces float in fixed DSP_BLOCK_FRAMES
+ *    blocks, re-blocked to the backend's callback size by a BlockAdapter;
+ *    the data callback converts to the device format itself when that
+ *    isn't f32.
+ *
+ *    Control calls (open / configure / start / stop / close) come from one
+ *    thread. Nothing here depends on Android; host builds can open the null
+ *    backend.
+ */
+class AudioOutput {
+public:
+    using Blocks = BlockAdapter<DSP_BLOCK_FRAMES, AUDIO_OUTPUT_CHANNELS>;
+
+    // Audio thread: write one block of DSP_BLOCK_FRAMES interleaved
+    // AUDIO_OUTPUT_CHANNELS float frames, DSP_BLOCK_ALIGNMENT aligned.
+    typedef Blocks::RenderBlock RenderCallback;
+
+    // What the device negotiated for the current profile. Published by
+    // configure(); info() may be read from any thread.
+    struct Info {
+        int profile = LATENCY_PROFILE_BALANCED;
+        uint32_t sampleRate = 0;
+        uint32_t periodFrames = 0;
+        uint32_t periods = 0;
+        bool exclusive = false;
+        int conversion = 0;  // AUDIO_CONVERSION_* flags
+        double openMs = 0.0; // time configure() spent opening the device
+    };
+
+    ~AudioOutput() { close(); }
+
+    // backends: null for the platform's default order.
+    bool open(RenderCallback render, void *user,
+              const ma_backend *backends = nullptr, uint32_t backendCount = 0);
+
+    void close();
+
+    // AudioManager's output sample rate and frames per buffer; 0 when unknown.
+    // Used by the next configure().
+    void setNativeParams(int sampleRate, int framesPerBuffer);
+
+    // Tears down any current device and creates a stopped one for profile.
+    // An exclusive stream that can't be opened is retried shared.
+    bool configure(int profile);
+
+    bool start();
+
+    void stop();
+
+    bool configured() const { return deviceInitialized; }
+
+    // A consistent copy, even while configure() runs on another thread.
+    Info info() const;
+
+    AudioCallbackStats::Snapshot stats() const { return callbackStats.snapshot(); }
+
+private:
+    static void dataCallback(ma_device *device, void *output, const void *input,
+                             ma_uint32 frameCount);
+
+    void publish(const Info &info);
+
+    RenderCallback render = nullptr;
+    void *renderUser = nullptr;
+    int nativeSampleRate = 0;
+    int nativeFramesPerBuffer = 0;
+
+    ma_context context;
+    bool contextInitialized = false;
+    ma_device device;
+    bool deviceInitialized = false;
+    Info current;                           // seqlock: odd infoSequence while rewritten
+    std::atomic<uint32_t> infoSequence{0};
+
+    AudioCallbackStats callbackStats;
+    Blocks blocks;
+    alignas(DSP_BLOCK_ALIGNMENT) float renderBuffer[RENDER_CHUNK_FRAMES * AUDIO_OUTPUT_CHANNELS];
+};
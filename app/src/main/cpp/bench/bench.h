@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+/*
+ * Benchmark helpers
+ *    Each benchmark times a body over a fixed amount of work several times
+ *    and keeps the fastest run, which is far more repeatable on a busy
+ *    machine than the mean. Inputs come from fixed seeds, so runs compare
+ *    across commits. --quick does a single short run; ctest uses it so the
+ *    benchmarks keep building and running without slowing the tests.
+ */
+struct BenchConfig {
+    int repeats = 15;
+    int scale = 1; // divides the iteration counts
+};
+
+inline BenchConfig &benchConfig() {
+    static BenchConfig config;
+    return config;
+}
+
+inline void benchInit(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            benchConfig().repeats = 1;
+            benchConfig().scale = 100;
+        }
+    }
+}
+
+// Iteration count for this run: at least one.
+inline long benchIterations(long iterations) {
+    long scaled = iterations / benchConfig().scale;
+    return scaled > 0 ? scaled : 1;
+}
+
+// Keeps a result alive so the timed work can't be optimised away.
+template<typename T>
+inline void benchKeep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Best time of body(iterations) over the configured repeats, in
+// nanoseconds per iteration.
+template<typename Body>
+double benchBest(long iterations, Body body) {
+    double best = 0.0;
+    for (int r = 0; r < benchConfig().repeats; r++) {
+        const auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        const double ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count() / double(iterations);
+        if (r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+inline void benchReport(const char *name, double value, const char *unit) {
+    printf("%-48s %10.2f %s\n", name, value, unit);
+}
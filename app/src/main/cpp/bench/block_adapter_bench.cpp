@@ -0,0 +1,71 @@
+// Cost of serving callbacks through BlockAdapter compared with rendering
+// the same frames as bare DSP_BLOCK_FRAMES blocks, for callback sizes the
+// backends actually use. The render is a plain fill so the adapter's
+// copying dominates any difference.
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "bench.h"
+#include "block_adapter.h"
+
+namespace {
+
+const int CHANNELS = 2;
+const long FRAMES = 1 << 22; // per timed run
+
+using Adapter = BlockAdapter<DSP_BLOCK_FRAMES, CHANNELS>;
+
+void renderBlock(void *user, float *block) {
+    float *value = (float *) user;
+    for (int i = 0; i < DSP_BLOCK_FRAMES * CHANNELS; i++) block[i] = *value;
+    *value += 1.0f;
+}
+
+struct Case {
+    const char *name;
+    uint32_t callbackFrames;
+    int offsetFloats; // from a DSP_BLOCK_ALIGNMENT boundary
+};
+
+const Case CASES[] = {
+        {"adapter 64 aligned (direct)", 64, 0},
+        {"adapter 192 aligned (direct)", 192, 0},
+        {"adapter 96 aligned", 96, 0},
+        {"adapter 240 aligned", 240, 0},
+        {"adapter 441 aligned", 441, 0},
+        {"adapter 192 misaligned", 192, 2},
+        {"adapter 1024 misaligned", 1024, 2},
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    const long frames = benchIterations(FRAMES);
+    std::vector<float> storage(2048 * CHANNELS + 64);
+    float *aligned = storage.data();
+    while (uintptr_t(aligned) % DSP_BLOCK_ALIGNMENT) aligned++;
+
+    float value = 0.0f;
+    const double bare = benchBest(frames, [&](long n) {
+        for (long done = 0; done < n; done += DSP_BLOCK_FRAMES) renderBlock(&value, aligned);
+        benchKeep(aligned[0]);
+    });
+    benchReport("bare blocks", bare, "ns/frame");
+
+    for (const Case &c : CASES) {
+        Adapter adapter;
+        float *out = aligned + c.offsetFloats;
+        const double ns = benchBest(frames, [&](long n) {
+            for (long done = 0; done < n; done += c.callbackFrames) {
+                adapter.read(out, c.callbackFrames, renderBlock, &value);
+            }
+            benchKeep(out[0]);
+        });
+        char label[64];
+        snprintf(label, sizeof(label), "%s (+%.0f%%)", c.name, 100.0 * (ns - bare) / bare);
+        benchReport(label, ns, "ns/frame");
+    }
+    return 0;
+}
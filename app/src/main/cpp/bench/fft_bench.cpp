@@ -0,0 +1,104 @@
+// RealFft::forward at the analyzer's FFT sizes, next to a textbook
+// iterative radix-2 complex FFT of the same real input (precomputed
+// twiddles, std::complex). Also checks the two agree, so a broken
+// transform fails the run rather than just getting faster.
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "fft.h"
+#include "spectrum_analyzer.h"
+
+namespace {
+
+const long POINTS = 1L << 22; // per size, so every size does similar work
+const float TOLERANCE = 1e-4f; // relative to the largest bin
+
+class ComplexFft {
+public:
+    explicit ComplexFft(int size) : n(size), twiddles(size / 2), work(size) {
+        for (int k = 0; k < n / 2; k++) {
+            twiddles[k] = std::polar(1.0f, float(-6.283185307179586 * k / n));
+        }
+    }
+
+    void forward(const float *in, float *re, float *im) {
+        for (int i = 0, j = 0; i < n; i++) {
+            work[j] = in[i];
+            // Bit-reversed increment of j.
+            int bit = n >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j |= bit;
+        }
+        for (int m = 2; m <= n; m <<= 1) {
+            const int step = n / m;
+            for (int s = 0; s < n; s += m) {
+                for (int k = 0; k < m / 2; k++) {
+                    const std::complex<float> t = twiddles[k * step] * work[s + k + m / 2];
+                    work[s + k + m / 2] = work[s + k] - t;
+                    work[s + k] += t;
+                }
+            }
+        }
+        for (int k = 0; k <= n / 2; k++) {
+            re[k] = work[k].real();
+            im[k] = work[k].imag();
+        }
+    }
+
+private:
+    int n;
+    std::vector<std::complex<float>> twiddles;
+    std::vector<std::complex<float>> work;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    std::mt19937 random(37);
+    std::uniform_real_distribution<float> values(-1.0f, 1.0f);
+    int failures = 0;
+
+    for (int size = SPECTRUM_MIN_FFT_SIZE; size <= SPECTRUM_MAX_FFT_SIZE; size *= 2) {
+        std::vector<float> in(size);
+        for (float &v : in) v = values(random);
+        RealFft fft(size);
+        ComplexFft reference(size);
+        std::vector<float> re(fft.bins()), im(fft.bins());
+        std::vector<float> expectedRe(fft.bins()), expectedIm(fft.bins());
+
+        fft.forward(in.data(), re.data(), im.data());
+        reference.forward(in.data(), expectedRe.data(), expectedIm.data());
+        float largest = 0.0f;
+        float error = 0.0f;
+        for (int k = 0; k < fft.bins(); k++) {
+            largest = std::max(largest, std::hypot(expectedRe[k], expectedIm[k]));
+            error = std::max(error, std::hypot(re[k] - expectedRe[k], im[k] - expectedIm[k]));
+        }
+        if (error > TOLERANCE * largest) {
+            fprintf(stderr, "size %d: error %g of %g\n", size, error, largest);
+            failures++;
+        }
+
+        const long transforms = benchIterations(POINTS / size);
+        char label[64];
+        snprintf(label, sizeof(label), "RealFft::forward, n=%d", size);
+        benchReport(label, benchBest(transforms, [&](long count) {
+            for (long i = 0; i < count; i++) fft.forward(in.data(), re.data(), im.data());
+            benchKeep(re[1]);
+        }) / 1000.0, "us");
+        snprintf(label, sizeof(label), "radix-2 complex reference, n=%d", size);
+        benchReport(label, benchBest(transforms, [&](long count) {
+            for (long i = 0; i < count; i++) {
+                reference.forward(in.data(), expectedRe.data(), expectedIm.data());
+            }
+            benchKeep(expectedRe[1]);
+        }) / 1000.0, "us");
+    }
+    return failures == 0 ? 0 : 1;
+}
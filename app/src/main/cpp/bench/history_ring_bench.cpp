@@ -0,0 +1,149 @@
+// Sensor history: the HistoryRing / SoAHistoryRing layout against the one
+// it replaced (an array of Vec3 written twice at index and index + length
+// with a modulo wrap, and a prox index that only ever grew). Measures a
+// sensor push, including what the seqlock's sequence store and release
+// fence add over the SoA push without them, and reading one channel's
+// window, as the trace upload does on the writer thread and as
+// snapshotWindow() does from another.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "history_ring.h"
+
+namespace {
+
+const int OLD_LENGTH = 100;  // the old SENSOR_HISTORY_LENGTH
+const int NEW_LENGTH = 128;
+const long PUSHES = 1 << 24;
+const long READS = 1 << 20;
+
+struct Vec3 {
+    float x, y, z;
+};
+
+struct OldHistory {
+    Vec3 accelData[OLD_LENGTH * 2]{};
+    int accelIndex = 0;
+    float proxData[OLD_LENGTH]{};
+    int proxIndex = 0;
+
+    void pushAccel(const Vec3 &v) {
+        accelData[accelIndex] = v;
+        accelData[OLD_LENGTH + accelIndex] = v;
+        accelIndex = (accelIndex + 1) % OLD_LENGTH;
+    }
+
+    void pushProx(float v) {
+        proxData[proxIndex % OLD_LENGTH] = v;
+        proxIndex = proxIndex + 1;
+    }
+
+    // Strided: every x is 12 bytes from the next.
+    float sumX() const {
+        float sum = 0.0f;
+        const Vec3 *window = &accelData[accelIndex];
+        for (int i = 0; i < OLD_LENGTH; i++) sum += window[i].x;
+        return sum;
+    }
+};
+
+// SoAHistoryRing::push() as it was before the sequence count.
+template<std::size_t Channels, std::size_t N>
+struct UnsequencedSoARing {
+    float data[Channels][N * 2]{};
+    std::atomic<uint64_t> written{0};
+
+    void push(const float *values) {
+        uint64_t count = written.load(std::memory_order_relaxed);
+        std::size_t slot = std::size_t(count) & (N - 1);
+        for (std::size_t c = 0; c < Channels; c++) {
+            data[c][slot] = values[c];
+            data[c][slot + N] = values[c];
+        }
+        written.store(count + 1, std::memory_order_release);
+    }
+};
+
+struct NewHistory {
+    SoAHistoryRing<float, 3, NEW_LENGTH> accel;
+    HistoryRing<float, NEW_LENGTH> prox;
+
+    float sumX() const {
+        float sum = 0.0f;
+        const float *window = accel.window(0);
+        for (int i = 0; i < NEW_LENGTH; i++) sum += window[i];
+        return sum;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> values(-10.0f, 10.0f);
+    std::vector<Vec3> samples(4096);
+    for (Vec3 &v : samples) v = {values(random), values(random), values(random)};
+    const long pushes = benchIterations(PUSHES);
+    const long reads = benchIterations(READS);
+
+    OldHistory *old = new OldHistory();
+    NewHistory *next = new NewHistory();
+    UnsequencedSoARing<3, NEW_LENGTH> *unsequenced = new UnsequencedSoARing<3, NEW_LENGTH>();
+
+    benchReport("old: accel push (AoS, modulo)", benchBest(pushes, [&](long n) {
+        for (long i = 0; i < n; i++) old->pushAccel(samples[i & 4095]);
+        benchKeep(old->accelIndex);
+    }), "ns/push");
+    benchReport("new: accel push (SoA, mask, seqlock)", benchBest(pushes, [&](long n) {
+        for (long i = 0; i < n; i++) next->accel.push(&samples[i & 4095].x);
+        benchKeep(*next->accel.window(0));
+    }), "ns/push");
+    benchReport("new: accel push without sequence count", benchBest(pushes, [&](long n) {
+        for (long i = 0; i < n; i++) unsequenced->push(&samples[i & 4095].x);
+        benchKeep(unsequenced->data[0][0]);
+    }), "ns/push");
+
+    benchReport("old: prox push (growing index)", benchBest(pushes, [&](long n) {
+        for (long i = 0; i < n; i++) old->pushProx(samples[i & 4095].x);
+        benchKeep(old->proxIndex);
+    }), "ns/push");
+    benchReport("new: prox push (HistoryRing)", benchBest(pushes, [&](long n) {
+        for (long i = 0; i < n; i++) next->prox.push(samples[i & 4095].x);
+        benchKeep(next->prox.latest());
+    }), "ns/push");
+
+    // Per sample, since the windows differ in length.
+    benchReport("old: read x window (stride 12 B)", benchBest(reads, [&](long n) {
+        float sum = 0.0f;
+        for (long i = 0; i < n; i++) {
+            sum += old->sumX();
+            benchKeep(sum);
+        }
+    }) / OLD_LENGTH, "ns/sample");
+    benchReport("new: read x window (contiguous)", benchBest(reads, [&](long n) {
+        float sum = 0.0f;
+        for (long i = 0; i < n; i++) {
+            sum += next->sumX();
+            benchKeep(sum);
+        }
+    }) / NEW_LENGTH, "ns/sample");
+    float window[NEW_LENGTH];
+    benchReport("new: snapshotWindow x (any thread)", benchBest(reads, [&](long n) {
+        float sum = 0.0f;
+        for (long i = 0; i < n; i++) {
+            next->accel.snapshotWindow(0, window);
+            for (float v : window) sum += v;
+            benchKeep(sum);
+        }
+    }) / NEW_LENGTH, "ns/sample");
+
+    delete old;
+    delete next;
+    delete unsequenced;
+    return 0;
+}
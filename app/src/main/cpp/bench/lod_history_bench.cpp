@@ -0,0 +1,73 @@
+// Cost of the min/max level-of-detail pyramid per sample (amortised and
+// on the sample that carries through every level) and of a whole
+// SensorHistories update drawing raw history, next to one at a LOD level,
+// which also feeds the pyramids. Memory is fixed, so it is printed rather
+// than timed.
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "sensor_history.h"
+
+namespace {
+
+const long SAMPLES = 1 << 24;
+const long UPDATES = 1 << 22;
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> values(-10.0f, 10.0f);
+    std::vector<float> samples(4096);
+    for (float &v : samples) v = values(random);
+    const long count = benchIterations(SAMPLES);
+    const long updates = benchIterations(UPDATES);
+
+    SensorLod *lod = new SensorLod();
+    benchReport("pyramid push, amortised", benchBest(count, [&](long n) {
+        for (long i = 0; i < n; i++) lod->push(samples[i & 4095]);
+        benchKeep(*lod->window(1));
+    }), "ns/sample");
+
+    // Sample 2^Levels - 1 completes a bucket at every level; time only
+    // that one, after the 2^Levels - 2 before it. Too short to time alone,
+    // so the figure includes reading the clock; the best of all periods
+    // keeps scheduler noise out.
+    const long period = 1L << SENSOR_HISTORY_LOD_LEVELS;
+    const long periods = count / period > 0 ? count / period : 1;
+    double best = 0.0;
+    for (long p = 0; p < periods; p++) {
+        for (long i = 0; i < period - 1; i++) lod->push(samples[i & 4095]);
+        const double ns = benchBest(1, [&](long) { lod->push(samples[p & 4095]); });
+        if (p == 0 || ns < best) best = ns;
+    }
+    benchKeep(*lod->window(SENSOR_HISTORY_LOD_LEVELS));
+    benchReport("pyramid push, every level (incl. clock)", best, "ns/sample");
+    delete lod;
+
+    SensorHistories *histories = new SensorHistories();
+    const char *labels[] = {"histories update, raw history drawn",
+                            "histories update, envelope drawn (pyramids fed)"};
+    for (int level : {0, 1}) {
+        histories->setLodLevel(level);
+        benchReport(labels[level], benchBest(updates, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                const float *s = &samples[(3 * i) & 4095];
+                histories->pushAccel(s);
+                histories->pushGyro(s + 1);
+                histories->pushProx(s[2]);
+            }
+            benchKeep(histories->prox.latest());
+        }), "ns/update");
+    }
+
+    printf("memory: %zu bytes per pyramid, %zu bytes of SensorHistories\n",
+           sizeof(SensorLod), sizeof(SensorHistories));
+    delete histories;
+    return 0;
+}
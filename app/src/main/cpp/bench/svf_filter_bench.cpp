@@ -0,0 +1,91 @@
+// SvfFilter::process per stereo frame in each mode, with the cutoff moving
+// every block as the sensors drive it, next to the same filter that glides
+// the cutoff itself and calls tan() every sample, which is what the
+// per-sample coefficient glide avoids.
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+
+#include "bench.h"
+#include "svf_filter.h"
+
+namespace {
+
+const float RATE = 48000.0f;
+const float RESONANCE = 0.6f;
+const long FRAMES = 1L << 22;
+const int SAMPLES = 2 * DSP_BLOCK_FRAMES;
+
+// Lowpass with the coefficients recomputed from a smoothed cutoff per sample.
+struct TanPerSample {
+    float cutoff = 1000.0f;
+    float cutoffTarget = 1000.0f;
+    float smoothing = 1.0f - std::exp(-1.0f / (SVF_SMOOTHING_SECONDS * RATE));
+    float k = 2.0f - 1.96f * RESONANCE;
+    float ic1[2] = {0.0f, 0.0f};
+    float ic2[2] = {0.0f, 0.0f};
+
+    void process(float *block, int frameCount) {
+        for (int f = 0; f < frameCount; f++) {
+            cutoff += smoothing * (cutoffTarget - cutoff);
+            const float g = std::tan(3.14159265f * cutoff / RATE);
+            const float a1 = 1.0f / (1.0f + g * (g + k));
+            const float a2 = g * a1;
+            const float a3 = g * a2;
+            for (int c = 0; c < 2; c++) {
+                const float v3 = block[2 * f + c] - ic2[c];
+                const float v1 = a1 * ic1[c] + a2 * v3;
+                const float v2 = ic2[c] + a2 * ic1[c] + a3 * v3;
+                ic1[c] = 2.0f * v1 - ic1[c];
+                ic2[c] = 2.0f * v2 - ic2[c];
+                block[2 * f + c] = v2;
+            }
+        }
+    }
+};
+
+float cutoffFor(long block) {
+    return 500.0f + 1000.0f * float(block & 7);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    const long blocks = benchIterations(FRAMES / DSP_BLOCK_FRAMES);
+    // Refilled every block (in both figures), so repeated filtering can't
+    // decay the input into denormals.
+    float input[SAMPLES];
+    for (int i = 0; i < SAMPLES; i++) input[i] = 0.5f * std::sin(0.1f * float(i));
+    alignas(DSP_BLOCK_ALIGNMENT) float block[SAMPLES];
+
+    const char *names[] = {"lowpass", "bandpass", "highpass"};
+    for (int mode : {SVF_LOWPASS, SVF_BANDPASS, SVF_HIGHPASS}) {
+        std::unique_ptr<SvfFilter> filter = std::make_unique<SvfFilter>();
+        filter->setMode(mode);
+        filter->setSampleRate(RATE);
+        char label[64];
+        snprintf(label, sizeof(label), "SvfFilter %s, moving cutoff", names[mode]);
+        benchReport(label, benchBest(blocks, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                std::memcpy(block, input, sizeof(block));
+                filter->setTarget(cutoffFor(i), RESONANCE);
+                filter->process(block, DSP_BLOCK_FRAMES);
+            }
+            benchKeep(block[0]);
+        }) / DSP_BLOCK_FRAMES, "ns/frame");
+    }
+
+    TanPerSample reference;
+    benchReport("tan() per sample lowpass, moving cutoff", benchBest(blocks, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            std::memcpy(block, input, sizeof(block));
+            reference.cutoffTarget = cutoffFor(i);
+            reference.process(block, DSP_BLOCK_FRAMES);
+        }
+        benchKeep(block[0]);
+    }) / DSP_BLOCK_FRAMES, "ns/frame");
+    return 0;
+}
@@ -0,0 +1,356 @@
+// TraceRenderer on a headless EGL pbuffer (e.g. Mesa llvmpipe), with the
+// shaders from the app's assets: CPU time of render() per frame and with
+// glFinish(), and the draw calls, uploads and upload bytes it issued per
+// frame, for the ES3 texture path and the ES2 segment path, drawing raw
+// history and, at LOD_LEVEL, min/max envelopes. Each also renders one
+// fixed frame that is read back and checked for trace pixels;
+// --write-image PREFIX saves it as PREFIX-<path>.ppm and --compare-image
+// PREFIX checks it against a saved one. Exits 77 (skipped) without EGL.
+// Built with -DTHERECELL_TRACING=ON, each frame is a "frame" trace scope
+// and SIGUSR1 dumps the trace to trace_render_bench.trace.json.
+//
+//   trace_render_bench [--quick] [--frames N] [--size WxH] [--assets DIR]
+//                      [--write-image PREFIX] [--compare-image PREFIX]
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "mapped_asset.h"
+#include "trace_events.h"
+#include "trace_renderer.h"
+
+namespace {
+
+const int SKIPPED = 77;
+const int LOD_LEVEL = 3; // envelope runs: 1024 samples per trace
+const int COMPARE_TOLERANCE = 8;       // per channel, 0..255
+const double COMPARE_MAX_DIFFERENT = 0.001; // fraction of pixels
+
+struct Options {
+    long frames = 2000;
+    int width = 1080;
+    int height = 720;
+    std::string assets = THERECELL_ASSET_DIR;
+    std::string writeImage;
+    std::string compareImage;
+};
+
+Options parse(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (hasValue && std::strcmp(argv[i], "--frames") == 0) {
+            options.frames = std::atol(argv[++i]);
+        } else if (hasValue && std::strcmp(argv[i], "--size") == 0) {
+            std::sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+        } else if (hasValue && std::strcmp(argv[i], "--assets") == 0) {
+            options.assets = argv[++i];
+        } else if (hasValue && std::strcmp(argv[i], "--write-image") == 0) {
+            options.writeImage = argv[++i];
+        } else if (hasValue && std::strcmp(argv[i], "--compare-image") == 0) {
+            options.compareImage = argv[++i];
+        }
+    }
+    return options;
+}
+
+struct Headless {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+
+    bool create(int width, int height) {
+        // Mesa's surfaceless platform needs no X or Wayland server.
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+                eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay != nullptr) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) return false;
+
+        const EGLint configAttributes[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+                EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+                EGL_NONE};
+        EGLConfig config;
+        EGLint configs = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs < 1) {
+            return false;
+        }
+        const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        const EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+        eglBindAPI(EGL_OPENGL_ES_API);
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        return surface != EGL_NO_SURFACE && context != EGL_NO_CONTEXT &&
+               eglMakeCurrent(display, surface, surface, context);
+    }
+
+    ~Headless() {
+        if (display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        eglTerminate(display);
+    }
+};
+
+// Deterministic sensor-like motion: slow swings plus a little fast ripple.
+void pushSample(SensorHistories &histories, long n) {
+    const float t = float(n) * 0.01f;
+    const float accel[3] = {4.0f * std::sin(t), 6.0f * std::sin(0.7f * t + 1.0f),
+                            9.0f + 0.5f * std::sin(13.0f * t)};
+    const float gyro[3] = {2.0f * std::cos(1.3f * t), std::sin(2.1f * t), 0.5f * std::cos(5.0f * t)};
+    histories.pushAccel(accel);
+    histories.pushGyro(gyro);
+    histories.pushProx((n / 80) % 2 == 0 ? 5.0f : 0.0f);
+}
+
+void prefill(SensorHistories &histories) {
+    histories.hasGyro = true;
+    histories.hasProx = true;
+    for (long n = 0; n < long(histories.visibleSamples()); n++) pushSample(histories, n);
+}
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgb;
+};
+
+Image readBack(int width, int height) {
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    Image image{width, height, std::vector<uint8_t>(size_t(width) * height * 3)};
+    // GL rows run bottom-up; PPM rows top-down.
+    for (int y = 0; y < height; y++) {
+        const uint8_t *src = &rgba[size_t(height - 1 - y) * width * 4];
+        uint8_t *dst = &image.rgb[size_t(y) * width * 3];
+        for (int x = 0; x < width; x++) std::memcpy(dst + 3 * x, src + 4 * x, 3);
+    }
+    return image;
+}
+
+bool writePpm(const std::string &path, const Image &image) {
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    std::fprintf(file, "P6\n%d %d\n255\n", image.width, image.height);
+    const bool ok = std::fwrite(image.rgb.data(), 1, image.rgb.size(), file) == image.rgb.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+bool readPpm(const std::string &path, Image &image) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    int maxValue = 0;
+    bool ok = std::fscanf(file, "P6 %d %d %d", &image.width, &image.height, &maxValue) == 3 &&
+              maxValue == 255 && std::fgetc(file) != EOF;
+    if (ok) {
+        image.rgb.resize(size_t(image.width) * image.height * 3);
+        ok = std::fread(image.rgb.data(), 1, image.rgb.size(), file) == image.rgb.size();
+    }
+    std::fclose(file);
+    return ok;
+}
+
+long litPixels(const Image &image) {
+    long lit = 0;
+    for (size_t i = 0; i < image.rgb.size(); i += 3) {
+        if (image.rgb[i] + image.rgb[i + 1] + image.rgb[i + 2] > 0) lit++;
+    }
+    return lit;
+}
+
+long differentPixels(const Image &a, const Image &b) {
+    if (a.width != b.width || a.height != b.height) return long(a.rgb.size() / 3);
+    long different = 0;
+    for (size_t i = 0; i < a.rgb.size(); i += 3) {
+        for (int c = 0; c < 3; c++) {
+            if (std::abs(int(a.rgb[i + c]) - int(b.rgb[i + c])) > COMPARE_TOLERANCE) {
+                different++;
+                break;
+            }
+        }
+    }
+    return different;
+}
+
+void clear() {
+    glClearColor(0.f, 0.f, 0.f, 1.0f);
+    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+}
+
+// Times one renderer path at one history level and checks its fixed
+// frame; returns failures.
+int runPath(const char *name, bool texture, int lodLevel, const Options &options,
+            const TraceShaders &shaders) {
+    int failures = 0;
+    SensorHistories *histories = new SensorHistories();
+    histories->setLodLevel(lodLevel);
+    prefill(*histories);
+    long sample = long(histories->visibleSamples());
+
+    TraceRenderer *renderer = new TraceRenderer();
+    renderer->allowHistoryTexture(texture);
+    renderer->surfaceCreated(shaders, *histories);
+    renderer->surfaceChanged(options.width, options.height);
+    renderer->setLineWidth(3.0f);
+
+    // The first frame uploads the whole history; that is its own figure.
+    clear();
+    renderer->render(*histories);
+    glFinish();
+    const TraceRenderer::Stats first = renderer->stats();
+    renderer->resetStats();
+
+    // Steady state: one new sample per trace per frame, as on device.
+    const long frames = benchIterations(options.frames);
+    double bestSubmit = 0.0;
+    double bestFinished = 0.0;
+    for (int r = 0; r < benchConfig().repeats; r++) {
+        double submit = 0.0;
+        const auto start = std::chrono::steady_clock::now();
+        for (long f = 0; f < frames; f++) {
+            pushSample(*histories, sample++);
+            clear();
+            const auto before = std::chrono::steady_clock::now();
+            {
+                TRACE_SCOPE("frame");
+                renderer->render(*histories);
+            }
+            submit += std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - before).count();
+            tracePollDump();
+        }
+        glFinish();
+        const double finished = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || submit < bestSubmit * frames) bestSubmit = submit / frames;
+        if (r == 0 || finished < bestFinished * frames) bestFinished = finished / frames;
+    }
+    const TraceRenderer::Stats &stats = renderer->stats();
+    const double counted = stats.frames > 0 ? double(stats.frames) : 1.0;
+
+    char label[96];
+    snprintf(label, sizeof(label), "%s: render() CPU", name);
+    benchReport(label, bestSubmit / 1000.0, "us/frame");
+    snprintf(label, sizeof(label), "%s: frame incl. clear and glFinish", name);
+    benchReport(label, bestFinished / 1000.0, "us/frame");
+    snprintf(label, sizeof(label), "%s: draw calls", name);
+    benchReport(label, double(stats.drawCalls) / counted, "/frame");
+    snprintf(label, sizeof(label), "%s: uploads", name);
+    benchReport(label, double(stats.uploadCalls) / counted, "/frame");
+    snprintf(label, sizeof(label), "%s: upload bytes", name);
+    benchReport(label, double(stats.uploadBytes) / counted, "B/frame");
+    snprintf(label, sizeof(label), "%s: first frame uploads", name);
+    benchReport(label, double(first.uploadCalls), "calls");
+    snprintf(label, sizeof(label), "%s: first frame upload bytes", name);
+    benchReport(label, double(first.uploadBytes), "B");
+    if (stats.drawCalls != stats.frames) {
+        fprintf(stderr, "%s: %llu draw calls over %llu frames\n", name,
+                (unsigned long long) stats.drawCalls, (unsigned long long) stats.frames);
+        failures++;
+    }
+    delete renderer;
+    delete histories;
+
+    // Fixed frame: fresh history and renderer, so it doesn't depend on
+    // --frames or --quick. Envelopes are switched to after a raw frame, as
+    // a level change at runtime would be.
+    histories = new SensorHistories();
+    histories->setLodLevel(lodLevel);
+    prefill(*histories);
+    histories->setLodLevel(0);
+    renderer = new TraceRenderer();
+    renderer->allowHistoryTexture(texture);
+    renderer->surfaceCreated(shaders, *histories);
+    renderer->surfaceChanged(options.width, options.height);
+    renderer->setLineWidth(3.0f);
+    clear();
+    renderer->render(*histories);
+    histories->setLodLevel(lodLevel);
+    clear();
+    renderer->render(*histories);
+    const Image image = readBack(options.width, options.height);
+    delete renderer;
+    delete histories;
+
+    const GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        fprintf(stderr, "%s: GL error 0x%x\n", name, error);
+        failures++;
+    }
+    const long lit = litPixels(image);
+    if (lit == 0) {
+        fprintf(stderr, "%s: nothing drawn\n", name);
+        failures++;
+    }
+    const std::string suffix = std::string("-") + name + ".ppm";
+    if (!options.writeImage.empty() && !writePpm(options.writeImage + suffix, image)) {
+        fprintf(stderr, "%s: can't write %s%s\n", name, options.writeImage.c_str(), suffix.c_str());
+        failures++;
+    }
+    if (!options.compareImage.empty()) {
+        Image expected;
+        if (!readPpm(options.compareImage + suffix, expected)) {
+            fprintf(stderr, "%s: can't read %s%s\n", name, options.compareImage.c_str(), suffix.c_str());
+            failures++;
+        } else {
+            const long different = differentPixels(image, expected);
+            printf("%s: %ld of %ld pixels differ from %s%s\n", name, different,
+                   long(image.rgb.size() / 3), options.compareImage.c_str(), suffix.c_str());
+            if (double(different) > COMPARE_MAX_DIFFERENT * double(image.rgb.size() / 3)) failures++;
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    const Options options = parse(argc, argv);
+    TRACE_THREAD_NAME("gl");
+    traceInstallSignalHandler("trace_render_bench.trace.json");
+
+    Headless headless;
+    if (!headless.create(options.width, options.height)) {
+        printf("no headless EGL context (0x%x); skipped\n", eglGetError());
+        return SKIPPED;
+    }
+    printf("%s | %s, %dx%d\n", (const char *) glGetString(GL_VERSION),
+           (const char *) glGetString(GL_RENDERER), options.width, options.height);
+
+    // Sources only need to stay mapped while the programs are built.
+    const std::string dir = options.assets + "/";
+    MappedAsset segmentVertex = MappedAsset::openFile((dir + "shader.glslv").c_str());
+    MappedAsset segmentFragment = MappedAsset::openFile((dir + "shader.glslf").c_str());
+    MappedAsset textureVertex = MappedAsset::openFile((dir + "shader_es3.glslv").c_str());
+    MappedAsset textureFragment = MappedAsset::openFile((dir + "shader_es3.glslf").c_str());
+    if (!segmentVertex.valid() || !segmentFragment.valid() ||
+        !textureVertex.valid() || !textureFragment.valid()) {
+        fprintf(stderr, "shaders not found in %s\n", options.assets.c_str());
+        return 1;
+    }
+    const TraceShaders shaders = {segmentVertex.view(), segmentFragment.view(),
+                                  textureVertex.view(), textureFragment.view()};
+
+    int failures = 0;
+    failures += runPath("texture", true, 0, options, shaders);
+    failures += runPath("segments", false, 0, options, shaders);
+    failures += runPath("texture-lod", true, LOD_LEVEL, options, shaders);
+    failures += runPath("segments-lod", false, LOD_LEVEL, options, shaders);
+    return failures == 0 ? 0 : 1;
+}
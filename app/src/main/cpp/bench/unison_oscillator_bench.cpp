@@ -0,0 +1,76 @@
+// UnisonOscillator::render per voice-sample for sine and saw stacks of 1 to
+// MAX_UNISON_VOICES copies, against the same stack built from one
+// ma_waveform per copy read with ma_waveform_read_pcm_frames and mixed.
+// ma_waveform's saw is not band-limited, so the saw comparison favours it.
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+
+#include "bench.h"
+#include "block_adapter.h"
+#include "miniaudio.h"
+#include "unison_oscillator.h"
+
+namespace {
+
+const float RATE = 48000.0f;
+const float FREQUENCY = 220.0f;
+const long VOICE_SAMPLES = 1L << 22; // per configuration
+const int SAMPLES = 2 * DSP_BLOCK_FRAMES;
+
+void report(const char *wave, int voices, const char *what, double ns) {
+    char label[64];
+    snprintf(label, sizeof(label), "%s x%d, %s", wave, voices, what);
+    benchReport(label, ns / double(voices * DSP_BLOCK_FRAMES), "ns/voice-sample");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    alignas(DSP_BLOCK_ALIGNMENT) float out[SAMPLES] = {};
+    float scratch[SAMPLES];
+
+    for (int wave : {UNISON_WAVE_SINE, UNISON_WAVE_SAW}) {
+        const char *name = wave == UNISON_WAVE_SAW ? "saw" : "sine";
+        for (int voices : {1, 4, 7, 8, MAX_UNISON_VOICES}) {
+            const long blocks = benchIterations(VOICE_SAMPLES / (voices * DSP_BLOCK_FRAMES));
+
+            std::unique_ptr<UnisonOscillator> unison = std::make_unique<UnisonOscillator>();
+            unison->setSampleRate(RATE);
+            unison->setWave(wave);
+            unison->setVoices(voices);
+            unison->reset();
+            // A moving pitch, as the sensors drive it, so set() is in the figure.
+            report(name, voices, "UnisonOscillator", benchBest(blocks, [&](long n) {
+                for (long i = 0; i < n; i++) {
+                    unison->set(FREQUENCY + float(i & 1), 0.5f, 0.5f);
+                    unison->render(out, DSP_BLOCK_FRAMES, 0.2f, 0.2f);
+                }
+                benchKeep(out[0]);
+            }));
+
+            ma_waveform waveforms[MAX_UNISON_VOICES];
+            for (int v = 0; v < voices; v++) {
+                const double detuned = FREQUENCY * std::exp2(double(v) / 1200.0);
+                ma_waveform_config config = ma_waveform_config_init(
+                        ma_format_f32, 2, ma_uint32(RATE),
+                        wave == UNISON_WAVE_SAW ? ma_waveform_type_sawtooth : ma_waveform_type_sine,
+                        0.2, detuned);
+                ma_waveform_init(&config, &waveforms[v]);
+            }
+            report(name, voices, "ma_waveform per copy", benchBest(blocks, [&](long n) {
+                for (long i = 0; i < n; i++) {
+                    for (int v = 0; v < voices; v++) {
+                        ma_waveform_read_pcm_frames(&waveforms[v], scratch, DSP_BLOCK_FRAMES, nullptr);
+                        for (int s = 0; s < SAMPLES; s++) out[s] += scratch[s];
+                    }
+                }
+                benchKeep(out[0]);
+            }));
+            for (int v = 0; v < voices; v++) ma_waveform_uninit(&waveforms[v]);
+        }
+    }
+    return 0;
+}
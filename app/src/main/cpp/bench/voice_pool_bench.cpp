@@ -0,0 +1,102 @@
+// VoicePool::render with 1 to MAX_VOICES sounding voices, per block and per
+// voice-sample, and as a share of one block's real time at 48 kHz; the
+// goal is 16 voices well inside the callback budget. Also a pool under
+// constant stealing (a note on every block with every voice busy) and a
+// whole Synth block with the lead and 16 pool voices playing.
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+
+#include "bench.h"
+#include "synth.h"
+#include "voice_pool.h"
+
+namespace {
+
+const float RATE = 48000.0f;
+const long BLOCKS = 1 << 15;
+const double BLOCK_NS = 1e9 * DSP_BLOCK_FRAMES / RATE;
+const long CHORD_PERIOD = 100; // blocks
+
+VoiceParams note(int v) {
+    VoiceParams params;
+    params.frequency = 110.0f + 37.0f * float(v);
+    params.brightness = 0.5f;
+    params.pan = float(v % 5) * 0.4f - 0.8f;
+    return params;
+}
+
+void reportBlock(const char *name, double ns, int voices) {
+    char label[64];
+    snprintf(label, sizeof(label), "%s, block", name);
+    benchReport(label, ns, "ns");
+    snprintf(label, sizeof(label), "%s, of block time", name);
+    benchReport(label, 100.0 * ns / BLOCK_NS, "%");
+    if (voices > 0) {
+        snprintf(label, sizeof(label), "%s, voice-sample", name);
+        benchReport(label, ns / (voices * DSP_BLOCK_FRAMES), "ns");
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    benchInit(argc, argv);
+    const long blocks = benchIterations(BLOCKS);
+    alignas(DSP_BLOCK_ALIGNMENT) float block[2 * DSP_BLOCK_FRAMES] = {};
+
+    for (int voices : {1, 4, 8, 16, MAX_VOICES}) {
+        std::unique_ptr<VoicePool> pool = std::make_unique<VoicePool>();
+        pool->setSampleRate(RATE);
+        for (int v = 0; v < voices; v++) pool->noteOn(note(v));
+        const double ns = benchBest(blocks, [&](long n) {
+            for (long i = 0; i < n; i++) pool->render(block, DSP_BLOCK_FRAMES);
+            benchKeep(block[0]);
+        });
+        char name[48];
+        snprintf(name, sizeof(name), "pool, %d voices", voices);
+        reportBlock(name, ns, voices);
+    }
+
+    std::unique_ptr<VoicePool> stealing = std::make_unique<VoicePool>();
+    stealing->setSampleRate(RATE);
+    for (int v = 0; v < MAX_VOICES; v++) stealing->noteOn(note(v));
+    long notes = 0;
+    const double stealNs = benchBest(blocks, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            stealing->noteOn(note(int(notes++ % MAX_VOICES)));
+            stealing->render(block, DSP_BLOCK_FRAMES);
+        }
+        benchKeep(block[0]);
+    });
+    reportBlock("pool, stealing every block", stealNs, MAX_VOICES);
+
+    // 16 chord notes every CHORD_PERIOD blocks, a little under their hold
+    // time, so the ones still releasing keep the pool about full.
+    std::unique_ptr<Synth> synth = std::make_unique<Synth>();
+    synth->configureLead(UNISON_WAVE_SAW, 7);
+    synth->configureFilter(SVF_LOWPASS);
+    synth->setLead(220.0f, 0.2f);
+    synth->setFilter(2000.0f, 0.4f);
+    synth->prepare(RATE);
+    synth->setGate(true);
+    long voiceBlocks = 0;
+    long renderedBlocks = 0;
+    const double synthNs = benchBest(blocks, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            if (i % CHORD_PERIOD == 0) {
+                for (int c = 0; c < 5; c++) synth->trigger(110.0f * float(c + 1), CHORD_MAJOR, 0.1f);
+                synth->trigger(880.0f, CHORD_SINGLE, 0.1f);
+            }
+            synth->render(block);
+            voiceBlocks += synth->activeVoices();
+        }
+        renderedBlocks += n;
+        benchKeep(block[0]);
+    });
+    char name[64];
+    snprintf(name, sizeof(name), "synth, lead + %.1f voices",
+             double(voiceBlocks) / double(renderedBlocks));
+    reportBlock(name, synthNs, 0);
+    return 0;
+}
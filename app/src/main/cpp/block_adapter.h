@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+const int DSP_BLOCK_FRAMES = 64;        // frames per internal DSP block
+const int DSP_BLOCK_ALIGNMENT = 64;     // bytes; blocks always start on this
+
+/*
+ * BlockAdapter<BlockFrames, Channels>
+ *    Lets the DSP graph run in fixed blocks of BlockFrames interleaved
+ *    frames, each starting on a DSP_BLOCK_ALIGNMENT boundary, while the
+ *    backend asks for arbitrary frame counts. read() first hands out what
+ *    is left of the previously rendered block, then renders whole blocks
+ *    straight into the output while it is suitably aligned, and renders the
+ *    tail into an aligned scratch block whose remainder is kept for the
+ *    next call. So at most one partial block is copied per side of a
+ *    callback, and callbacks that are a multiple of BlockFrames with an
+ *    aligned buffer are never copied at all.
+ *
+ *    Control changes take effect at block boundaries, up to BlockFrames - 1
+ *    frames later than without the adapter. Audio thread only.
+ */
+template<int BlockFrames, int Channels>
+class BlockAdapter {
+    static_assert(BlockFrames > 0 && (BlockFrames & (BlockFrames - 1)) == 0,
+                  "BlockAdapter block size must be a power of two");
+
+public:
+    static constexpr std::size_t kBlockSamples = std::size_t(BlockFrames) * Channels;
+
+    // Renders exactly BlockFrames frames into an aligned block.
+    typedef void (*RenderBlock)(void *user, float *block);
+
+    void read(float *out, uint32_t frameCount, RenderBlock render, void *user) {
+        if (pending > 0) {
+            uint32_t take = frameCount < pending ? frameCount : pending;
+            const float *from = scratch + std::size_t(BlockFrames - pending) * Channels;
+            std::memcpy(out, from, std::size_t(take) * Channels * sizeof(float));
+            out += std::size_t(take) * Channels;
+            frameCount -= take;
+            pending -= take;
+        }
+        if (std::uintptr_t(out) % DSP_BLOCK_ALIGNMENT == 0) {
+            for (; frameCount >= uint32_t(BlockFrames); frameCount -= BlockFrames) {
+                render(user, out);
+                out += kBlockSamples;
+            }
+        }
+        while (frameCount > 0) {
+            render(user, scratch);
+            uint32_t take = frameCount < uint32_t(BlockFrames) ? frameCount : uint32_t(BlockFrames);
+            std::memcpy(out, scratch, std::size_t(take) * Channels * sizeof(float));
+            out += std::size_t(take) * Channels;
+            frameCount -= take;
+            pending = BlockFrames - take;
+        }
+    }
+
+    // Drops the rest of the last block, e.g. when the device restarts.
+    void reset() { pending = 0; }
+
+    uint32_t pendingFrames() const { return pending; }
+
+private:
+    alignas(DSP_BLOCK_ALIGNMENT) float scratch[kBlockSamples];
+    uint32_t pending = 0;
+};
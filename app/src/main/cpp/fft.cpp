@@ -0,0 +1,96 @@
+#include "fft.h"
+
+#include <cassert>
+#include <cmath>
+
+RealFft::RealFft(int size) : n(size), half(size / 2) {
+    assert(size >= 8 && (size & (size - 1)) == 0);
+    const double twoPi = 6.283185307179586;
+
+    int bits = 0;
+    while ((1 << bits) < half) bits++;
+    bitReverse.resize(half);
+    for (int k = 0; k < half; k++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) r |= ((k >> b) & 1) << (bits - 1 - b);
+        bitReverse[k] = r;
+    }
+
+    for (int m = 8; m <= half; m *= 2) {
+        for (int j = 0; j < m / 2; j++) {
+            stageRe.push_back(float(std::cos(twoPi * j / m)));
+            stageIm.push_back(float(-std::sin(twoPi * j / m)));
+        }
+    }
+
+    splitRe.resize(half);
+    splitIm.resize(half);
+    for (int k = 0; k < half; k++) {
+        splitRe[k] = float(std::cos(twoPi * k / n));
+        splitIm[k] = float(-std::sin(twoPi * k / n));
+    }
+
+    workRe.resize(half);
+    workIm.resize(half);
+}
+
+void RealFft::forward(const float *in, float *re, float *im) {
+    float *wr = workRe.data();
+    float *wi = workIm.data();
+
+    // Even samples are the real part, odd samples the imaginary part.
+    for (int k = 0; k < half; k++) {
+        wr[bitReverse[k]] = in[2 * k];
+        wi[bitReverse[k]] = in[2 * k + 1];
+    }
+
+    // Stages of span 2 and 4 fused: twiddles are 1 and -i, so no multiplies.
+    for (int b = 0; b < half; b += 4) {
+        float a0r = wr[b] + wr[b + 1], a0i = wi[b] + wi[b + 1];
+        float a1r = wr[b] - wr[b + 1], a1i = wi[b] - wi[b + 1];
+        float a2r = wr[b + 2] + wr[b + 3], a2i = wi[b + 2] + wi[b + 3];
+        float a3r = wr[b + 2] - wr[b + 3], a3i = wi[b + 2] - wi[b + 3];
+        wr[b] = a0r + a2r;
+        wi[b] = a0i + a2i;
+        wr[b + 2] = a0r - a2r;
+        wi[b + 2] = a0i - a2i;
+        // a3 * -i = (a3i, -a3r)
+        wr[b + 1] = a1r + a3i;
+        wi[b + 1] = a1i - a3r;
+        wr[b + 3] = a1r - a3i;
+        wi[b + 3] = a1i + a3r;
+    }
+
+    for (int m = 8; m <= half; m *= 2) {
+        const int h = m / 2;
+        const float *tr = &stageRe[h - 4];
+        const float *ti = &stageIm[h - 4];
+        for (int b = 0; b < half; b += m) {
+            float *ur = wr + b, *ui = wi + b;
+            float *vr = wr + b + h, *vi = wi + b + h;
+            for (int j = 0; j < h; j++) {
+                float xr = vr[j] * tr[j] - vi[j] * ti[j];
+                float xi = vr[j] * ti[j] + vi[j] * tr[j];
+                vr[j] = ur[j] - xr;
+                vi[j] = ui[j] - xi;
+                ur[j] = ur[j] + xr;
+                ui[j] = ui[j] + xi;
+            }
+        }
+    }
+
+    // X[k] = E[k] + e^(-2 pi i k / n) O[k], where E and O are the spectra of
+    // the even and odd samples recovered from Z[k] and conj(Z[half - k]).
+    re[0] = wr[0] + wi[0];
+    im[0] = 0.0f;
+    re[half] = wr[0] - wi[0];
+    im[half] = 0.0f;
+    for (int k = 1; k < half; k++) {
+        const float zr = wr[k], zi = wi[k];
+        const float cr = wr[half - k], ci = wi[half - k];
+        const float er = 0.5f * (zr + cr), ei = 0.5f * (zi - ci);
+        const float orr = 0.5f * (zi + ci), oi = -0.5f * (zr - cr);
+        re[k] = er + splitRe[k] * orr - splitIm[k] * oi;
+        im[k] = ei + splitRe[k] * oi + splitIm[k] * orr;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * RealFft
+ *    Forward FFT of size() real samples, size() a power of two >= 8. The
+ *    input is packed as size() / 2 complex points, transformed in place in
+ *    split re/im arrays (one radix-4 pass for the first two stages, then
+ *    radix-2 stages) and unpacked into size() / 2 + 1 bins. All twiddles
+ *    and the bit-reversal permutation are computed once by the constructor;
+ *    every inner loop is unit-stride over separate re/im arrays so the
+ *    compiler can vectorise it (NEON on arm64, SSE on x86).
+ *
+ *    Allocates only in the constructor. Not for the audio thread.
+ */
+class RealFft {
+public:
+    explicit RealFft(int size);
+
+    int size() const { return n; }
+
+    int bins() const { return n / 2 + 1; }
+
+    // Writes bins() values to re and im (DC first).
+    void forward(const float *in, float *re, float *im);
+
+private:
+    int n;
+    int half;
+    std::vector<int> bitReverse;      // half entries
+    // Stage twiddles e^(-2 pi i j / m) for m = 8, 16, ..., half, m / 2 each,
+    // stored back to back so stage m starts at m / 2 - 4.
+    std::vector<float> stageRe, stageIm;
+    // e^(-2 pi i k / n) for unpacking the real spectrum.
+    std::vector<float> splitRe, splitIm;
+    std::vector<float> workRe, workIm;
+};
@@ -0,0 +1,192 @@
+#include "gl_program.h"
+
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+#include <sys/stat.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "logging.h"
+
+namespace {
+
+std::string cacheDir;
+ProgramCacheStats cacheStats;
+
+// glGetProgramBinary / glProgramBinary are core in ES 3.0; ES 2.0 contexts
+// need GL_OES_get_program_binary.
+struct ProgramBinaryApi {
+    PFNGLGETPROGRAMBINARYOESPROC getProgramBinary = nullptr;
+    PFNGLPROGRAMBINARYOESPROC programBinary = nullptr;
+    bool es3 = false;
+};
+
+const uint32_t CACHE_MAGIC = 0x74637062; // "tcpb"
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+};
+
+bool programBinaryApi(ProgramBinaryApi &api) {
+    if (cacheDir.empty()) return false;
+    const char *version = (const char *) glGetString(GL_VERSION);
+    api.es3 = version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0;
+    if (api.es3) {
+        api.getProgramBinary = glGetProgramBinary;
+        api.programBinary = glProgramBinary;
+    } else {
+        const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+        if (extensions == nullptr || strstr(extensions, "GL_OES_get_program_binary") == nullptr) {
+            return false;
+        }
+        api.getProgramBinary =
+                (PFNGLGETPROGRAMBINARYOESPROC) eglGetProcAddress("glGetProgramBinaryOES");
+        api.programBinary = (PFNGLPROGRAMBINARYOESPROC) eglGetProcAddress("glProgramBinaryOES");
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    return formats > 0 && api.getProgramBinary != nullptr && api.programBinary != nullptr;
+}
+
+uint64_t fnv1a(uint64_t hash, const char *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string cachePath(std::string_view vertexSource, std::string_view fragmentSource) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const GLenum identity[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : identity) {
+        const char *value = (const char *) glGetString(name);
+        if (value != nullptr) hash = fnv1a(hash, value, strlen(value) + 1);
+    }
+    hash = fnv1a(hash, vertexSource.data(), vertexSource.size());
+    hash = fnv1a(hash, "", 1);
+    hash = fnv1a(hash, fragmentSource.data(), fragmentSource.size());
+    char name[40];
+    snprintf(name, sizeof(name), "/program-%016llx.bin", (unsigned long long) hash);
+    return cacheDir + name;
+}
+
+GLuint loadCachedProgram(const ProgramBinaryApi &api, const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return 0;
+    CacheHeader header;
+    std::vector<char> binary;
+    struct stat info;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == CACHE_MAGIC;
+    // The length must match the file before it sizes an allocation: a
+    // truncated or corrupt file could otherwise ask for up to 4 GiB.
+    ok = ok && header.length > 0 && fstat(fileno(file), &info) == 0 &&
+         uint64_t(info.st_size) == sizeof(header) + uint64_t(header.length);
+    if (ok) {
+        binary.resize(header.length);
+        ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+    if (!ok) {
+        remove(path.c_str());
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    api.programBinary(program, header.format, binary.data(), GLint(binary.size()));
+    GLint programLinked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &programLinked);
+    if (programLinked == 0) {
+        // Driver update or corrupt file: drop it and relink from source.
+        glDeleteProgram(program);
+        remove(path.c_str());
+        return 0;
+    }
+    return program;
+}
+
+void storeProgram(const ProgramBinaryApi &api, GLuint program, const std::string &path) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) return;
+    std::vector<char> binary(length);
+    CacheHeader header = {CACHE_MAGIC, 0, 0};
+    GLsizei written = 0;
+    GLenum format = 0;
+    api.getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+    header.format = format;
+    header.length = uint32_t(written);
+
+    // Write then rename so a crash never leaves a truncated binary behind.
+    std::string temp = path + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (file == nullptr) return;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(binary.data(), 1, size_t(written), file) == size_t(written);
+    ok = fclose(file) == 0 && ok;
+    if (ok && rename(temp.c_str(), path.c_str()) == 0) {
+        cacheStats.stores++;
+    } else {
+        remove(temp.c_str());
+    }
+}
+
+} // namespace
+
+void setProgramCacheDir(const std::string &dir) { cacheDir = dir; }
+
+const ProgramCacheStats &programCacheStats() { return cacheStats; }
+
+GLuint loadShader(GLenum shaderType, std::string_view pSource) {
+    GLuint shader = glCreateShader(shaderType);
+    assert(shader != 0);
+    // Sources are mapped assets, not NUL-terminated strings.
+    const char *sourceBuf = pSource.data();
+    const GLint sourceLength = GLint(pSource.size());
+    glShaderSource(shader, 1, &sourceBuf, &sourceLength);
+    glCompileShader(shader);
+    GLint shaderCompiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &shaderCompiled);
+    assert(shaderCompiled != 0);
+    return shader;
+}
+
+GLuint createProgram(std::string_view pVertexSource, std::string_view pFragmentSource) {
+    ProgramBinaryApi api;
+    const bool cacheable = programBinaryApi(api);
+    std::string path;
+    if (cacheable) {
+        path = cachePath(pVertexSource, pFragmentSource);
+        GLuint cached = loadCachedProgram(api, path);
+        if (cached != 0) {
+            cacheStats.hits++;
+            return cached;
+        }
+        cacheStats.misses++;
+    }
+
+    GLuint vertexShader = loadShader(GL_VERTEX_SHADER, pVertexSource);
+    GLuint pixelShader = loadShader(GL_FRAGMENT_SHADER, pFragmentSource);
+    GLuint program = glCreateProgram();
+    assert(program != 0);
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, pixelShader);
+    if (cacheable && api.es3) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    GLint programLinked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &programLinked);
+    assert(programLinked != 0);
+    glDeleteShader(vertexShader);
+    glDeleteShader(pixelShader);
+    if (cacheable) storeProgram(api, program, path);
+    return program;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <string>
+#include <string_view>
+
+struct ProgramCacheStats {
+    int hits = 0;
+    int misses = 0;
+    int stores = 0;
+};
+
+// Directory for linked program binaries (the app cache dir on device).
+// Leaving it empty, or a driver without binary formats, compiles from
+// source every time.
+void setProgramCacheDir(const std::string &dir);
+
+const ProgramCacheStats &programCacheStats();
+
+GLuint loadShader(GLenum shaderType, std::string_view pSource);
+
+// Links a program from source, or restores it from the binary cache when a
+// binary for the same sources and driver (vendor, renderer, version) exists.
+GLuint createProgram(std::string_view pVertexSource, std::string_view pFragmentSource);
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * HistoryRing<T, N>
+ *    Fixed-size history of the last N samples. N must be a power of two so
+ *    indexing is a mask instead of a modulo. Every sample is written twice
+ *    (at slot and slot + N) so the last N samples are always available as
+ *    one contiguous window, oldest first, which can be handed straight to
+ *    glVertexAttribPointer / glBufferSubData.
+ *
+ *    One thread may push(); window() and latest() are for that thread,
+ *    while count() may be polled from any thread. The write counter is
+ *    64-bit and never wraps in practice.
+ */
+template<typename T, std::size_t N>
+class HistoryRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "HistoryRing length must be a power of two");
+
+public:
+    static constexpr std::size_t kLength = N;
+    static constexpr std::size_t kMask = N - 1;
+
+    void push(const T &value) {
+        uint64_t count = written.load(std::memory_order_relaxed);
+        std::size_t slot = std::size_t(count) & kMask;
+        data[slot] = value;
+        data[slot + N] = value;
+        written.store(count + 1, std::memory_order_release);
+    }
+
+    // Last N samples, oldest first. Only safe to read on the writer thread.
+    const T *window() const {
+        return &data[std::size_t(written.load(std::memory_order_relaxed)) & kMask];
+    }
+
+    const T &latest() const {
+        return data[(std::size_t(written.load(std::memory_order_relaxed)) - 1) & kMask];
+    }
+
+    uint64_t count() const { return written.load(std::memory_order_acquire); }
+
+    // Whole 2N mirrored storage; slot s and s + N hold the same sample.
+    const T *mirror() const { return data; }
+
+private:
+    T data[N * 2]{};
+    std::atomic<uint64_t> written{0};
+};
+
+/*
+ * SoAHistoryRing<T, Channels, N>
+ *    Same as HistoryRing but stores each channel (e.g. x/y/z) in its own
+ *    mirrored array, so a single channel window is tightly packed.
+ *
+ *    push() also keeps a sequence count that is odd while a slot is being
+ *    rewritten, so snapshotLatest(), snapshotWindow() and snapshotSince()
+ *    can copy from another thread without ever returning a torn sample.
+ */
+template<typename T, std::size_t Channels, std::size_t N>
+class SoAHistoryRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "HistoryRing length must be a power of two");
+
+public:
+    static constexpr std::size_t kLength = N;
+    static constexpr std::size_t kChannels = Channels;
+    static constexpr std::size_t kMask = N - 1;
+
+    void push(const T *values) {
+        uint64_t count = written.load(std::memory_order_relaxed);
+        std::size_t slot = std::size_t(count) & kMask;
+        sequence.store(2 * count + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t c = 0; c < Channels; c++) {
+            data[c][slot] = values[c];
+            data[c][slot + N] = values[c];
+        }
+        sequence.store(2 * count + 2, std::memory_order_release);
+        written.store(count + 1, std::memory_order_release);
+    }
+
+    // Last N samples of one channel, oldest first. Writer thread only.
+    const T *window(std::size_t channel) const {
+        return &data[channel][std::size_t(written.load(std::memory_order_relaxed)) & kMask];
+    }
+
+    const T &latest(std::size_t channel) const {
+        return data[channel][(std::size_t(written.load(std::memory_order_relaxed)) - 1) & kMask];
+    }
+
+    uint64_t count() const { return written.load(std::memory_order_acquire); }
+
+    // Whole 2N mirrored storage of one channel.
+    const T *mirror(std::size_t channel) const { return data[channel]; }
+
+    // Copies the newest sample of every channel into out[Channels] from any
+    // thread; returns the write count it belongs to (0, with out untouched,
+    // before the first push). Retries while a push overlaps the copy.
+    uint64_t snapshotLatest(T *out) const {
+        for (;;) {
+            const uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            const uint64_t count = before / 2;
+            if (count == 0) return 0;
+            const std::size_t slot = std::size_t(count - 1) & kMask;
+            for (std::size_t c = 0; c < Channels; c++) out[c] = data[c][slot];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) return count;
+        }
+    }
+
+    // Copies the last N samples of one channel, oldest first, into out[N]
+    // from any thread, as window() would return them on the writer thread;
+    // returns the write count they end at. The oldest slot is the next one
+    // rewritten, so any push during the copy means a retry.
+    uint64_t snapshotWindow(std::size_t channel, T *out) const {
+        for (;;) {
+            const uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            const uint64_t count = before / 2;
+            const T *window = &data[channel][std::size_t(count) & kMask];
+            for (std::size_t i = 0; i < N; i++) out[i] = window[i];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) return count;
+        }
+    }
+
+    // Copies the frames written since write count `from`, at most the
+    // newest N, from any thread: frame max(from, count - N) + i of channel c
+    // goes to out[c * stride + i]. Returns the write count the copy ends at.
+    // Retries only while a push rewrites a slot being copied.
+    uint64_t snapshotSince(uint64_t from, T *out, std::size_t stride) const {
+        for (;;) {
+            const uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            const uint64_t count = before / 2;
+            const uint64_t first = from > count ? count : count - from > N ? count - N : from;
+            const std::size_t slot = std::size_t(first) & kMask;
+            const std::size_t length = std::size_t(count - first);
+            for (std::size_t c = 0; c < Channels; c++) {
+                for (std::size_t i = 0; i < length; i++) out[c * stride + i] = data[c][slot + i];
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Frame f's slot is rewritten by frame f + N; pushes started so
+            // far include one in progress.
+            const uint64_t started = (sequence.load(std::memory_order_relaxed) + 1) / 2;
+            if (first + N >= started) return count;
+        }
+    }
+
+private:
+    T data[Channels][N * 2]{};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> sequence{0}; // 2 * written, plus one during a push
+};
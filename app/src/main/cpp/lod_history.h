@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+
+#include "history_ring.h"
+
+/*
+ * MinMaxPyramid<N, Levels>
+ *    Multi-resolution history of one channel. Level k (1..Levels) keeps the
+ *    last N buckets of 2^k raw samples each as (min, max) pairs, so level k
+ *    spans N * 2^k samples with the same N-bucket footprint. Buckets are
+ *    folded in as samples arrive: level k is touched once every 2^k
+ *    samples, so push() costs at most Levels steps and amortises to two.
+ *    Memory is fixed at Levels * 2N pairs.
+ *
+ *    Each window is laid out as min0, max0, min1, max1, ... which draws as
+ *    a 2N-vertex GL_LINE_STRIP envelope regardless of the time span.
+ */
+template<std::size_t N, std::size_t Levels>
+class MinMaxPyramid {
+    static_assert(Levels > 0, "MinMaxPyramid needs at least one level");
+
+public:
+    struct Range {
+        float min, max;
+    };
+
+    static constexpr std::size_t kLength = N;
+    static constexpr std::size_t kLevels = Levels;
+
+    void push(float value) {
+        Range r{value, value};
+        for (std::size_t k = 0; k < Levels; k++) {
+            if (!halfFull[k]) {
+                pending[k] = r;
+                halfFull[k] = true;
+                return;
+            }
+            r.min = pending[k].min < r.min ? pending[k].min : r.min;
+            r.max = pending[k].max > r.max ? pending[k].max : r.max;
+            halfFull[k] = false;
+            levels[k].push(r);
+        }
+    }
+
+    // Level 1 is the first decimated level (2 samples per bucket); level
+    // Levels covers the longest span. Returns 2N floats, oldest first;
+    // buckets not yet completed read as (0, 0).
+    const float *window(std::size_t level) const {
+        return &levels[level - 1].window()->min;
+    }
+
+private:
+    HistoryRing<Range, N> levels[Levels];
+    Range pending[Levels]{};
+    bool halfFull[Levels]{};
+};
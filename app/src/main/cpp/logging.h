@@ -0,0 +1,14 @@
+#pragma once
+
+#define LOG_TAG "therecell"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+
+// Host builds (Linux harnesses) log to stderr.
+#define LOGI(...) (fprintf(stderr, LOG_TAG ": " __VA_ARGS__), fputc('\n', stderr))
+#endif
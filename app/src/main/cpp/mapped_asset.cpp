@@ -0,0 +1,103 @@
+#include "mapped_asset.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// mmap needs a page-aligned offset, so map from the page holding offset.
+bool mapRange(int fd, off_t offset, size_t length, void *&base, size_t &mapLength,
+              const void *&data) {
+    if (length == 0) return false;
+    const off_t page = off_t(sysconf(_SC_PAGESIZE));
+    const off_t alignedOffset = offset - offset % page;
+    const size_t delta = size_t(offset - alignedOffset);
+    void *mapped = mmap(nullptr, length + delta, PROT_READ, MAP_PRIVATE, fd, alignedOffset);
+    if (mapped == MAP_FAILED) return false;
+    base = mapped;
+    mapLength = length + delta;
+    data = static_cast<const char *>(mapped) + delta;
+    return true;
+}
+
+} // namespace
+
+MappedAsset::MappedAsset(MappedAsset &&other) noexcept { *this = static_cast<MappedAsset &&>(other); }
+
+MappedAsset &MappedAsset::operator=(MappedAsset &&other) noexcept {
+    if (this == &other) return *this;
+    release();
+    data = other.data;
+    length = other.length;
+    mapBase = other.mapBase;
+    mapLength = other.mapLength;
+    other.data = nullptr;
+    other.length = 0;
+    other.mapBase = nullptr;
+    other.mapLength = 0;
+#ifdef __ANDROID__
+    asset = other.asset;
+    other.asset = nullptr;
+#endif
+    return *this;
+}
+
+MappedAsset::~MappedAsset() { release(); }
+
+void MappedAsset::release() {
+    if (mapBase != nullptr) munmap(mapBase, mapLength);
+#ifdef __ANDROID__
+    if (asset != nullptr) AAsset_close(asset);
+    asset = nullptr;
+#endif
+    mapBase = nullptr;
+    mapLength = 0;
+    data = nullptr;
+    length = 0;
+}
+
+#ifdef __ANDROID__
+MappedAsset MappedAsset::open(AAssetManager *assetManager, const char *name) {
+    MappedAsset mapped;
+    AAsset *asset = AAssetManager_open(assetManager, name, AASSET_MODE_BUFFER);
+    if (asset == nullptr) return mapped;
+
+    off_t start = 0, length = 0;
+    int fd = AAsset_openFileDescriptor(asset, &start, &length);
+    if (fd >= 0) {
+        bool ok = mapRange(fd, start, size_t(length), mapped.mapBase, mapped.mapLength,
+                           mapped.data);
+        close(fd);
+        if (ok) {
+            mapped.length = size_t(length);
+            AAsset_close(asset);
+            return mapped;
+        }
+    }
+
+    // Compressed in the APK: the asset manager inflates it for us.
+    mapped.data = AAsset_getBuffer(asset);
+    if (mapped.data == nullptr) {
+        AAsset_close(asset);
+        return mapped;
+    }
+    mapped.length = size_t(AAsset_getLength(asset));
+    mapped.asset = asset;
+    return mapped;
+}
+#endif
+
+MappedAsset MappedAsset::openFile(const char *path) {
+    MappedAsset mapped;
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return mapped;
+    struct stat info;
+    if (fstat(fd, &info) == 0 &&
+        mapRange(fd, 0, size_t(info.st_size), mapped.mapBase, mapped.mapLength, mapped.data)) {
+        mapped.length = size_t(info.st_size);
+    }
+    close(fd);
+    return mapped;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#ifdef __ANDROID__
+#include <android/asset_manager.h>
+#endif
+
+/*
+ * MappedAsset
+ *    Read-only view of a packaged file without copying it into a heap
+ *    string. On device an uncompressed APK asset is mmapped through
+ *    AAsset_openFileDescriptor; compressed assets fall back to
+ *    AAsset_getBuffer and keep the AAsset open for the view's lifetime.
+ *    On Linux openFile() mmaps a plain file. The view is released by the
+ *    destructor, so keep the object alive only as long as the data is used
+ *    (e.g. until the shaders are linked).
+ */
+class MappedAsset {
+public:
+    MappedAsset() = default;
+    MappedAsset(MappedAsset &&other) noexcept;
+    MappedAsset &operator=(MappedAsset &&other) noexcept;
+    MappedAsset(const MappedAsset &) = delete;
+    MappedAsset &operator=(const MappedAsset &) = delete;
+    ~MappedAsset();
+
+#ifdef __ANDROID__
+    static MappedAsset open(AAssetManager *assetManager, const char *name);
+#endif
+    static MappedAsset openFile(const char *path);
+
+    bool valid() const { return data != nullptr; }
+
+    std::string_view view() const { return {static_cast<const char *>(data), length}; }
+
+private:
+    void release();
+
+    const void *data = nullptr;
+    size_t length = 0;
+    void *mapBase = nullptr;   // set when the view is an mmap of our own
+    size_t mapLength = 0;
+#ifdef __ANDROID__
+    AAsset *asset = nullptr;   // set when the view is AAsset_getBuffer memory
+#endif
+};
@@ -0,0 +1,5 @@
+// miniaudio's implementation, compiled once as its own static library. The
+// backend and feature selection lives on the CMake target (PUBLIC, so code
+// including miniaudio.h sees the same configuration).
+#define MINIAUDIO_IMPLEMENTATION
+#include "miniaudio.h"
@@ -1,28 +1,37 @@
 #include <jni.h>
 #include <string>
 
-// OpenGL ES 2.0 code
-#include <GLES2/gl2.h>
+// OpenGL ES 2.0 code, plus an ES 3.0 path when the context supports it
+#include <GLES3/gl3.h>
 #include <android/asset_manager_jni.h>
-#include <android/log.h>
 #include <android/sensor.h>
 #include <dlfcn.h>
 #include <jni.h>
 
-#define MINIAUDIO_IMPLEMENTATION
-
 #include "miniaudio.h"
-
+#include "audio_callback_stats.h"
+#include "audio_output.h"
+#include "gl_program.h"
+#include "logging.h"
+#include "mapped_asset.h"
+#include "output_stage.h"
+#include "scope_renderer.h"
+#include "sensor_history.h"
+#include "spectrum_analyzer.h"
+#include "spectrum_renderer.h"
+#include "synth.h"
+#include "trace_events.h"
+#include "trace_renderer.h"
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string>
-
-#define LOG_TAG "therecell"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-
-#define DEVICE_FORMAT       ma_format_f32
-#define DEVICE_CHANNELS     2
-#define DEVICE_SAMPLE_RATE  48000
+#include <thread>
 
 const int GYRO_MODE = 0;
 const int ACCEL_MODE = 1;
@@ -32,11 +41,37 @@ const int POS_MODE = 3;
 const int SENSOR_MODE = ACCEL_MODE;
 
 const int LOOPER_ID_USER = 3;
-const int SENSOR_HISTORY_LENGTH = 100;
 const int SENSOR_REFRESH_RATE_HZ = 100;
 constexpr int32_t SENSOR_REFRESH_PERIOD_US =
         int32_t(1000000 / SENSOR_REFRESH_RATE_HZ);
 const float SENSOR_FILTER_ALPHA = 0.1f;
+const int RENDER_STATS_LOG_INTERVAL = 600; // frames
+constexpr int64_t AUDIO_STATS_LOG_INTERVAL_NS = int64_t(10) * 1000000000;
+const float TRACE_LINE_WIDTH_DP = 1.5f;
+// Render on demand redraws when a filtered sensor value has moved this far
+// since the last redraw (traces span +-9.81 over the screen height, so this
+// is about a pixel), and then until that change has scrolled off the trace.
+const float SENSOR_REDRAW_THRESHOLD = 0.02f;
+const int SPECTRUM_VIEW = SPECTRUM_VIEW_SPECTROGRAM;
+const int LEAD_WAVE = UNISON_WAVE_SAW;
+const int LEAD_UNISON_VOICES = 7; // 1..MAX_UNISON_VOICES
+const int FILTER_SOURCE_GYRO = 0; // |angular velocity|: faster motion opens the filter
+const int FILTER_SOURCE_PROX = 1; // proximity distance: a hand over the phone closes it
+const int FILTER_MODE = SVF_LOWPASS;
+const int FILTER_SOURCE = FILTER_SOURCE_GYRO;
+const float FILTER_RESONANCE = 0.6f;
+const float FILTER_MIN_CUTOFF_HZ = 300.0f;
+const float FILTER_MAX_CUTOFF_HZ = 8000.0f;
+const AdsrParams LEAD_ENVELOPE = {0.01f, 0.15f, 0.7f, 0.5f}; // attack, decay, sustain, release
+// Motion energy: |linear acceleration| in m/s^2 plus MOTION_GYRO_WEIGHT per
+// rad/s of rotation. The lead sounds above MOTION_GATE_ON and is released
+// below MOTION_GATE_OFF, so jitter around one threshold can't retrigger it.
+const float MOTION_GYRO_WEIGHT = 2.0f;
+const float MOTION_GATE_ON = 0.8f;
+const float MOTION_GATE_OFF = 0.3f;
+const int CHORD_MODE = CHORD_MAJOR;
+const float GESTURE_TAP_THRESHOLD = 8.0f; // m/s^2 of linear acceleration; re-armed below half
+const float GESTURE_NOTE_GAIN = 0.15f;
 
 /*
  * AcquireASensorManagerInstance(void)
@@ -66,8 +101,7 @@ ASensorManager *AcquireASensorManagerInstance(void) {
 }
 
 class sensorgraph {
-    std::string vertexShaderSource;
-    std::string fragmentShaderSource;
+    AAssetManager *assetManager;
     ASensorManager *sensorManager;
     const ASensor *accelerometer;
     const ASensor *gyroscope;                 // NEW
@@ -77,61 +111,88 @@ class sensorgraph {
     ASensorEventQueue *proximityEventQueue;   // NEW
     ALooper *looper;
 
-    GLuint shaderProgram;
-    GLuint vPositionHandle;
-    GLuint vSensorValueHandle;
-    GLuint uFragColorHandle;
-    GLfloat xPos[SENSOR_HISTORY_LENGTH];
+    SensorHistories histories;
+    TraceRenderer traceRenderer;
+
+    // Decimated audio output, written by data_callback and drawn as a
+    // triggered oscilloscope trace over the sensor traces.
+    OutputScopeTap scopeTap;
+    ScopeRenderer scopeRenderer;
+    std::atomic<uint64_t> scopeDrawn{0};
+    std::atomic<uint64_t> scopeAudibleEnd{0}; // tap count after the last audible block
+
+    // Full-rate audio output for the spectrum analyzer, which runs on its
+    // own thread and is drawn behind the traces.
+    SpectrumTap spectrumTap;
+    SpectrumAnalyzer spectrumAnalyzer;
+    SpectrumRenderer spectrumRenderer;
+    std::atomic<uint64_t> spectrumDrawn{0};
+
+    // Render-on-demand: requestFrame() runs on the GL thread once per vsync,
+    // drains the sensors and only schedules a redraw when the traces would
+    // visibly move, the output isn't silence or the surface changed, no
+    // faster than maxFrameRate.
+    std::atomic<bool> renderDirty{true};
+    std::atomic<int64_t> minFrameIntervalNs{0};
+    int64_t lastFrameRequestNs = 0;
+    std::atomic<uint64_t> framesRendered{0};
+    std::atomic<uint64_t> framesSkipped{0};
+    bool sensorsUpdated = false; // by requestFrame() since the last drawFrame()
+
+    // Context creation to first submitted frame, logged once per context.
+    std::chrono::steady_clock::time_point surfaceCreatedTime;
+    bool firstFramePending = false;
 
     struct Vec3 {
-        GLfloat x, y, z;
+        float x, y, z;
     };
 
-    // --- Accelerometer buffers ---
-    Vec3 accelData[SENSOR_HISTORY_LENGTH * 2]{}; // duplicated buffer trick
     Vec3 accelFilter{0.f, 0.f, 0.f};
-    int accelIndex = 0;
-
-    // --- Gyroscope buffers ---
-    Vec3 gyroData[SENSOR_HISTORY_LENGTH * 2]{};  // duplicated buffer trick
     Vec3 gyroFilter{0.f, 0.f, 0.f};
-    int gyroIndex = 0;
-
-    float proxData[SENSOR_HISTORY_LENGTH]{};
     float proxFilter = 0.f;
-    int proxIndex = 0;
+
+    // Filtered values as of the last visible change, and when that was
+    // (in update() calls, one history sample each).
+    Vec3 accelShown{0.f, 0.f, 0.f};
+    Vec3 gyroShown{0.f, 0.f, 0.f};
+    float proxShown = 0.f;
+    uint64_t sensorUpdates = 0;
+    uint64_t lastVisibleChange = 0;
 
     float velocityZ = 0.f;
     float posZ = 0.f;
 
-    ma_waveform sineWave;
-    ma_device_config deviceConfig;
-    ma_device device;
+    Synth synth;
+    OutputStage outputStage;
+    float leadFrequency = 220.0f;
+    float leadGain = 0.2f;
+    float accelPeak = 0.0f; // largest raw linear acceleration since the last update()
+    bool gestureArmed = true;
+    bool motionGate = false;
+    AudioOutput audioOutput;
     bool audioInitialized = false;
+    bool audioPaused = false;
+    // Resume latency: resume() stamps resumeNs and raises
+    // firstAudiblePending; the first block afterwards with a nonzero sample
+    // out of the output stage stamps firstAudibleNs. With the motion gate
+    // closed that waits for the first movement.
+    int64_t resumeNs = 0;
+    double resumeStartMs = 0.0;
+    std::atomic<bool> firstAudiblePending{false};
+    std::atomic<int64_t> firstAudibleNs{0};
+    bool resumeReportPending = false;
+    int latencyProfile = LATENCY_PROFILE_BALANCED;
+
+    AudioCallbackStats::Snapshot loggedCallbackStats;
+    int64_t callbackStatsLoggedNs = 0;
 
 public:
     sensorgraph() = default;
 
-    void init(AAssetManager *assetManager) {
-        AAsset *vertexShaderAsset =
-                AAssetManager_open(assetManager, "shader.glslv", AASSET_MODE_BUFFER);
-        assert(vertexShaderAsset != nullptr);
-        const void *vertexShaderBuf = AAsset_getBuffer(vertexShaderAsset);
-        assert(vertexShaderBuf != NULL);
-        off_t vertexShaderLength = AAsset_getLength(vertexShaderAsset);
-        vertexShaderSource =
-                std::string((const char *) vertexShaderBuf, (size_t) vertexShaderLength);
-        AAsset_close(vertexShaderAsset);
-
-        AAsset *fragmentShaderAsset =
-                AAssetManager_open(assetManager, "shader.glslf", AASSET_MODE_BUFFER);
-        assert(fragmentShaderAsset != NULL);
-        const void *fragmentShaderBuf = AAsset_getBuffer(fragmentShaderAsset);
-        assert(fragmentShaderBuf != NULL);
-        off_t fragmentShaderLength = AAsset_getLength(fragmentShaderAsset);
-        fragmentShaderSource = std::string((const char *) fragmentShaderBuf,
-                                           (size_t) fragmentShaderLength);
-        AAsset_close(fragmentShaderAsset);
+    void init(AAssetManager *assetManager, const std::string &cacheDir) {
+        this->assetManager = assetManager;
+        setProgramCacheDir(cacheDir);
+        traceInstallSignalHandler((cacheDir + "/trace.json").c_str());
 
         // --- Sensors setup ---
         sensorManager = AcquireASensorManagerInstance();
@@ -146,6 +207,9 @@ public:
 
         proximity = ASensorManager_getDefaultSensor(sensorManager, ASENSOR_TYPE_PROXIMITY); // NEW
 
+        histories.hasGyro = gyroscope != nullptr;
+        histories.hasProx = proximity != nullptr;
+
         looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
         assert(looper != nullptr);
 
@@ -182,131 +246,249 @@ public:
             status = ASensorEventQueue_setEventRate(proximityEventQueue, proximity, SENSOR_REFRESH_PERIOD_US);
             assert(status >= 0);
         }
+    }
 
-        generateXPos();
+    // Audio thread: the float DSP chain, rendering one DSP_BLOCK_FRAMES block.
+    static void renderAudio(void *user, float *block) {
+        sensorgraph *self = (sensorgraph *) user;
+        self->synth.render(block);
+        const bool audible = self->outputStage.process(block);
+        // The limiter's lookahead makes the first non-silent block zeros;
+        // only scanned while a resume is waiting to be timed.
+        if (audible && self->firstAudiblePending.load(std::memory_order_relaxed) &&
+            std::any_of(block, block + DSP_BLOCK_FRAMES * AUDIO_OUTPUT_CHANNELS,
+                        [](float s) { return s != 0.0f; })) {
+            self->firstAudibleNs.store(AudioCallbackStats::now(), std::memory_order_relaxed);
+            self->firstAudiblePending.store(false, std::memory_order_release);
+        }
+        self->scopeTap.write(block, DSP_BLOCK_FRAMES, AUDIO_OUTPUT_CHANNELS);
+        if (audible) self->scopeAudibleEnd.store(self->scopeTap.count(), std::memory_order_relaxed);
+        self->spectrumTap.write(block, DSP_BLOCK_FRAMES, AUDIO_OUTPUT_CHANNELS);
     }
 
-    static void
-    data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
-        ma_waveform *pSineWave = (ma_waveform *) pDevice->pUserData;
-        ma_waveform_read_pcm_frames(pSineWave, pOutput, frameCount, nullptr);
-        (void) pInput;
+    // Called before initAudio() with AudioManager's output sample rate and
+    // frames per buffer (0 when unknown).
+    void setNativeAudioParams(int sampleRate, int framesPerBuffer) {
+        audioOutput.setNativeParams(sampleRate, framesPerBuffer);
     }
 
     void initAudio() {
         if (audioInitialized) return;
-
-        deviceConfig = ma_device_config_init(ma_device_type_playback);
-        deviceConfig.playback.format = DEVICE_FORMAT;
-        deviceConfig.playback.channels = DEVICE_CHANNELS;
-        deviceConfig.sampleRate = DEVICE_SAMPLE_RATE;
-        deviceConfig.dataCallback = data_callback;
-        deviceConfig.pUserData = &sineWave;
-
-        if (ma_device_init(nullptr, &deviceConfig, &device) != MA_SUCCESS) {
+        if (!audioOutput.open(renderAudio, this) || !audioOutput.configure(latencyProfile)) {
             LOGI("Failed to initialize audio device");
             return;
         }
 
-        ma_waveform_config sineWaveConfig = ma_waveform_config_init(
-                device.playback.format,
-                device.playback.channels,
-                device.sampleRate,
-                ma_waveform_type_sine,
-                0.2f,    // amplitude
-                220.0f   // frequency
-        );
-        ma_waveform_init(&sineWaveConfig, &sineWave);
-
-        if (ma_device_start(&device) != MA_SUCCESS) {
+        // Rate-dependent state is built for the rate the device ended up at.
+        synth.configureLead(LEAD_WAVE, LEAD_UNISON_VOICES);
+        synth.configureFilter(FILTER_MODE);
+        synth.configureEnvelope(LEAD_ENVELOPE);
+        synth.setLead(leadFrequency, leadGain);
+        synth.prepare(float(audioOutput.info().sampleRate));
+        outputStage.prepare(float(audioOutput.info().sampleRate));
+
+        callbackStatsLoggedNs = AudioCallbackStats::now();
+        if (!audioOutput.start()) {
             LOGI("Failed to start audio device");
-            ma_device_uninit(&device);
             return;
         }
 
         audioInitialized = true;
         LOGI("Audio device started!");
+        spectrumAnalyzer.start(spectrumTap, float(audioOutput.info().sampleRate));
+    }
+
+    // Reopens the device with another LATENCY_PROFILE_*; the context and the
+    // DSP state are kept, so only the stream is recreated. Falls back to the
+    // previous profile if the new one can't be opened.
+    void setLatencyProfile(int profile) {
+        profile = std::clamp(profile, 0, LATENCY_PROFILE_COUNT - 1);
+        if (!audioInitialized) {
+            latencyProfile = profile;
+            return;
+        }
+        if (profile == latencyProfile) return;
+        const auto restartStart = std::chrono::steady_clock::now();
+        audioOutput.stop();
+        spectrumAnalyzer.stop();
+        if (audioOutput.configure(profile)) {
+            latencyProfile = profile;
+        } else if (!audioOutput.configure(latencyProfile)) {
+            audioInitialized = false;
+            return;
+        }
+        const uint32_t sampleRate = audioOutput.info().sampleRate;
+        synth.prepare(float(sampleRate));
+        outputStage.prepare(float(sampleRate));
+        if (audioPaused) return; // resume() starts it
+        if (!audioOutput.start()) {
+            audioInitialized = false;
+            return;
+        }
+        spectrumAnalyzer.start(spectrumTap, float(sampleRate));
+        std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - restartStart;
+        LOGI("audio: restarted in %.1f ms", elapsed.count());
     }
 
     void surfaceCreated() {
+        TRACE_THREAD_NAME("gl");
+        surfaceCreatedTime = std::chrono::steady_clock::now();
+        firstFramePending = true;
         LOGI("GL_VERSION: %s", glGetString(GL_VERSION));
         LOGI("GL_VENDOR: %s", glGetString(GL_VENDOR));
         LOGI("GL_RENDERER: %s", glGetString(GL_RENDERER));
-        LOGI("GL_EXTENSIONS: %s", glGetString(GL_EXTENSIONS));
-
-        shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
-        assert(shaderProgram != 0);
-        GLint getPositionLocationResult =
-                glGetAttribLocation(shaderProgram, "vPosition");
-        assert(getPositionLocationResult != -1);
-        vPositionHandle = (GLuint) getPositionLocationResult;
-        GLint getSensorValueLocationResult =
-                glGetAttribLocation(shaderProgram, "vSensorValue");
-        assert(getSensorValueLocationResult != -1);
-        vSensorValueHandle = (GLuint) getSensorValueLocationResult;
-        GLint getFragColorLocationResult =
-                glGetUniformLocation(shaderProgram, "uFragColor");
-        assert(getFragColorLocationResult != -1);
-        uFragColorHandle = (GLuint) getFragColorLocationResult;
+
+        // Shader sources are only mapped while the programs are built.
+        MappedAsset segmentVertex = MappedAsset::open(assetManager, "shader.glslv");
+        MappedAsset segmentFragment = MappedAsset::open(assetManager, "shader.glslf");
+        MappedAsset textureVertex = MappedAsset::open(assetManager, "shader_es3.glslv");
+        MappedAsset textureFragment = MappedAsset::open(assetManager, "shader_es3.glslf");
+        assert(segmentVertex.valid() && segmentFragment.valid());
+        assert(textureVertex.valid() && textureFragment.valid());
+        TraceShaders shaders = {segmentVertex.view(), segmentFragment.view(),
+                                textureVertex.view(), textureFragment.view()};
+        traceRenderer.surfaceCreated(shaders, histories);
+
+        MappedAsset scopeVertex = MappedAsset::open(assetManager, "scope.glslv");
+        MappedAsset scopeFragment = MappedAsset::open(assetManager, "scope.glslf");
+        assert(scopeVertex.valid() && scopeFragment.valid());
+        scopeRenderer.surfaceCreated(scopeVertex.view(), scopeFragment.view());
+
+        MappedAsset spectrumVertex = MappedAsset::open(assetManager, "spectrum.glslv");
+        MappedAsset spectrogramVertex = MappedAsset::open(assetManager, "spectrogram_es3.glslv");
+        MappedAsset spectrogramFragment = MappedAsset::open(assetManager, "spectrogram_es3.glslf");
+        assert(spectrumVertex.valid());
+        assert(spectrogramVertex.valid() && spectrogramFragment.valid());
+        SpectrumShaders spectrumShaders = {spectrumVertex.view(), scopeFragment.view(),
+                                           spectrogramVertex.view(), spectrogramFragment.view()};
+        spectrumRenderer.surfaceCreated(spectrumShaders);
+        spectrumRenderer.setView(SPECTRUM_VIEW);
+    }
+
+    void surfaceChanged(int w, int h) {
+        traceRenderer.surfaceChanged(w, h);
+        renderDirty = true;
+    }
+
+    void setDisplayDensity(float density) {
+        traceRenderer.setLineWidth(TRACE_LINE_WIDTH_DP * density);
+    }
+
+    static bool moved(const Vec3 &a, const Vec3 &b) {
+        return std::fabs(a.x - b.x) > SENSOR_REDRAW_THRESHOLD ||
+               std::fabs(a.y - b.y) > SENSOR_REDRAW_THRESHOLD ||
+               std::fabs(a.z - b.z) > SENSOR_REDRAW_THRESHOLD;
+    }
+
+    // After update(): notes a change worth drawing. Sensors keep delivering
+    // events while the phone lies still, so their arrival alone isn't one.
+    void trackVisibleChange() {
+        sensorUpdates++;
+        if (moved(accelFilter, accelShown) || moved(gyroFilter, gyroShown) ||
+            std::fabs(proxFilter - proxShown) > SENSOR_REDRAW_THRESHOLD) {
+            accelShown = accelFilter;
+            gyroShown = gyroFilter;
+            proxShown = proxFilter;
+            lastVisibleChange = sensorUpdates;
+        }
     }
 
-    void surfaceChanged(int w, int h) { glViewport(0, 0, w, h); }
+    // True while the last visible change is still on screen, scrolling.
+    bool tracesMoving() const {
+        return sensorUpdates - lastVisibleChange < histories.visibleSamples();
+    }
+
+    // New scope samples only change the picture until everything the
+    // trigger searches (two windows) is silence.
+    bool scopeChanged() const {
+        const uint64_t drawn = scopeDrawn.load();
+        return scopeTap.count() != drawn &&
+               drawn < scopeAudibleEnd.load(std::memory_order_relaxed) + 2 * SCOPE_WINDOW;
+    }
+
+    // Likewise new spectra once every frame the view shows is at the floor;
+    // a silent spectrogram stops scrolling.
+    bool spectrumChanged() const {
+        const uint64_t drawn = spectrumDrawn.load();
+        return spectrumAnalyzer.framesAnalyzed() != drawn &&
+               drawn < spectrumAnalyzer.audibleEnd() + uint64_t(spectrumRenderer.framesShown());
+    }
 
-    void generateXPos() {
-        for (auto i = 0; i < SENSOR_HISTORY_LENGTH; i++) {
-            float t =
-                    static_cast<float>(i) / static_cast<float>(SENSOR_HISTORY_LENGTH - 1);
-            xPos[i] = -1.f * (1.f - t) + 1.f * t;
+    // Called on the GL thread each vsync (queued from the UI thread): drains
+    // the sensors and returns true when a redraw should be requested.
+    // Frames not requested are counted as skipped.
+    bool requestFrame(int64_t frameTimeNs) {
+        update();
+        sensorsUpdated = true;
+        bool due = frameTimeNs - lastFrameRequestNs >= minFrameIntervalNs.load() &&
+                   (renderDirty.exchange(false) || tracesMoving() ||
+                    scopeChanged() || spectrumChanged());
+        if (due) {
+            lastFrameRequestNs = frameTimeNs;
+        } else {
+            framesSkipped++;
         }
+        return due;
+    }
+
+    void setMaxFrameRate(int fps) {
+        minFrameIntervalNs = fps > 0 ? int64_t(1000000000) / fps : 0;
+    }
+
+    void setSpectrumConfig(int fftSize, int hop) {
+        spectrumAnalyzer.configure(fftSize, hop);
+    }
+
+    // Before the GL thread starts, like the other settings: the sensor
+    // path and TraceRenderer read the level there without a lock.
+    void setHistoryLodLevel(int level) {
+        histories.setLodLevel(level);
+        renderDirty = true;
+    }
+
+    AudioCallbackStats::Snapshot audioStats() const {
+        return audioOutput.stats();
+    }
+
+    AudioOutput::Info audioInfo() const {
+        return audioOutput.info();
     }
 
-    GLuint createProgram(const std::string &pVertexSource,
-                         const std::string &pFragmentSource) {
-        GLuint vertexShader = loadShader(GL_VERTEX_SHADER, pVertexSource);
-        GLuint pixelShader = loadShader(GL_FRAGMENT_SHADER, pFragmentSource);
-        GLuint program = glCreateProgram();
-        assert(program != 0);
-        glAttachShader(program, vertexShader);
-        glAttachShader(program, pixelShader);
-        glLinkProgram(program);
-        GLint programLinked = 0;
-        glGetProgramiv(program, GL_LINK_STATUS, &programLinked);
-        assert(programLinked != 0);
-        glDeleteShader(vertexShader);
-        glDeleteShader(pixelShader);
-        return program;
+    const OutputStage &output() const {
+        return outputStage;
     }
 
-    GLuint loadShader(GLenum shaderType, const std::string &pSource) {
-        GLuint shader = glCreateShader(shaderType);
-        assert(shader != 0);
-        const char *sourceBuf = pSource.c_str();
-        glShaderSource(shader, 1, &sourceBuf, NULL);
-        glCompileShader(shader);
-        GLint shaderCompiled = 0;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &shaderCompiled);
-        assert(shaderCompiled != 0);
-        return shader;
+    void frameStats(uint64_t &rendered, uint64_t &skipped) const {
+        rendered = framesRendered.load();
+        skipped = framesSkipped.load();
     }
 
     void update() {
+        TRACE_SCOPE("update");
+        tracePollDump();
         ALooper_pollOnce(0, NULL, NULL, NULL);
         ASensorEvent event;
         float a = SENSOR_FILTER_ALPHA;
 
         // --- Accelerometer ---
-        while (ASensorEventQueue_getEvents(accelerometerEventQueue, &event, 1) > 0) {
-            if (event.type == ASENSOR_TYPE_ACCELEROMETER ||
-                event.type == ASENSOR_TYPE_LINEAR_ACCELERATION) {
-                accelFilter.x = a * event.acceleration.x + (1.0f - a) * accelFilter.x;
-                accelFilter.y = a * event.acceleration.y + (1.0f - a) * accelFilter.y;
-                accelFilter.z = a * event.acceleration.z + (1.0f - a) * accelFilter.z;
+        {
+            TRACE_SCOPE("drain accel");
+            while (ASensorEventQueue_getEvents(accelerometerEventQueue, &event, 1) > 0) {
+                if (event.type == ASENSOR_TYPE_ACCELEROMETER ||
+                    event.type == ASENSOR_TYPE_LINEAR_ACCELERATION) {
+                    accelFilter.x = a * event.acceleration.x + (1.0f - a) * accelFilter.x;
+                    accelFilter.y = a * event.acceleration.y + (1.0f - a) * accelFilter.y;
+                    accelFilter.z = a * event.acceleration.z + (1.0f - a) * accelFilter.z;
+                    accelPeak = std::max(accelPeak, std::sqrt(
+                            event.acceleration.x * event.acceleration.x +
+                            event.acceleration.y * event.acceleration.y +
+                            event.acceleration.z * event.acceleration.z));
+                }
             }
+            const float sample[3] = {accelFilter.x, accelFilter.y, accelFilter.z};
+            histories.pushAccel(sample);
         }
-        // write to circular buffer twice (wrapping trick for contiguous slice)
-        accelData[accelIndex] = accelFilter;
-        accelData[SENSOR_HISTORY_LENGTH + accelIndex] = accelFilter;
-        accelIndex = (accelIndex + 1) % SENSOR_HISTORY_LENGTH;
 
         float dt = 1.0f / SENSOR_REFRESH_RATE_HZ;
         velocityZ += accelFilter.z * dt;
@@ -325,6 +507,7 @@ public:
 
         // --- Gyroscope (rad/s) ---
         if (gyroscope && gyroscopeEventQueue) {
+            TRACE_SCOPE("drain gyro");
             while (ASensorEventQueue_getEvents(gyroscopeEventQueue, &event, 1) > 0) {
                 if (event.type == ASENSOR_TYPE_GYROSCOPE) {
                     // event.vector.{x,y,z} are angular velocities in rad/s
@@ -333,21 +516,20 @@ public:
                     gyroFilter.z = a * event.vector.z + (1.0f - a) * gyroFilter.z;
                 }
             }
-            gyroData[gyroIndex] = gyroFilter;
-            gyroData[SENSOR_HISTORY_LENGTH + gyroIndex] = gyroFilter;
-            gyroIndex = (gyroIndex + 1) % SENSOR_HISTORY_LENGTH;
+            const float sample[3] = {gyroFilter.x, gyroFilter.y, gyroFilter.z};
+            histories.pushGyro(sample);
         }
 
         if (proximity && proximityEventQueue) {
+            TRACE_SCOPE("drain prox");
             while (ASensorEventQueue_getEvents(proximityEventQueue, &event, 1) > 0) {
                 if (event.type == ASENSOR_TYPE_PROXIMITY) {
                     proxFilter = a * event.distance + (1.0f - a) * proxFilter;
                 }
             }
-            proxData[proxIndex % SENSOR_HISTORY_LENGTH] = proxFilter; // Apply modulo here
-            // No need to wrap around for proxData as it's not a circular buffer for rendering (yet)
-            proxIndex = (proxIndex + 1); // Allow proxIndex to grow, then take modulo when accessing
+            histories.pushProx(proxFilter);
         }
+        trackVisibleChange();
 
         // Map x acceleration to a reasonable frequency range
         // Example: map -10..10 m/s² to 200Hz..1000Hz
@@ -359,7 +541,7 @@ public:
                 float minFreq = 200.f, maxFreq = 1000.f;
                 float t = (std::fmin(std::fmax(gyroZ, gMin), gMax) - gMin) / (gMax - gMin);
                 float freq = minFreq + t * (maxFreq - minFreq);
-                ma_waveform_set_frequency(&sineWave, freq);
+                leadFrequency = freq;
             }
             else if (SENSOR_MODE == PROX_MODE) {
                 float prox = proxFilter;
@@ -367,20 +549,20 @@ public:
                 float minFreq = 200.f, maxFreq = 1000.f;
                 float t = (std::fmin(std::fmax(prox, pMin), pMax) - pMin) / (pMax - pMin);
                 float freq = minFreq + t * (maxFreq - minFreq);
-                ma_waveform_set_frequency(&sineWave, freq);
+                leadFrequency = freq;
             }
             else if (SENSOR_MODE == POS_MODE) {
                 float posMin = 0.0f, posMax = 5.0f;
                 float minFreq = 200.f, maxFreq = 1000.f;
                 float t = (std::fmin(std::fmax(posZ, posMin), posMax) - posMin) / (posMax - posMin);
                 float freq = minFreq + t * (maxFreq - minFreq);
-                ma_waveform_set_frequency(&sineWave, freq);
+                leadFrequency = freq;
             }
             else if (SENSOR_MODE == ACCEL_MODE) {
                 float accelX = fabs(accelFilter.x);
-                accelX = ma_clamp(accelX, 0.0f, 5.0f);
+                accelX = std::clamp(accelX, 0.0f, 5.0f);
 
-                float accelZ = ma_clamp(accelFilter.z, -5.0f, 5.0f);
+                float accelZ = std::clamp(accelFilter.z, -5.0f, 5.0f);
 
                 float minAmp = 0.0f, maxAmp = 5.0f;
                 float minFreq = 200.f, maxFreq = 1000.f;
@@ -392,74 +574,200 @@ public:
                 float t = (accelZ - minAmp) / (maxAmp - minAmp);
                 float freq = minFreq + t * (maxFreq - minFreq);
 
-                ma_waveform_set_amplitude(&sineWave, amp);
-                ma_waveform_set_frequency(&sineWave, freq);
+                leadGain = amp;
+                leadFrequency = freq;
+            }
+            synth.setLead(leadFrequency, leadGain);
+
+            float accelMagnitude = std::sqrt(accelFilter.x * accelFilter.x +
+                                             accelFilter.y * accelFilter.y +
+                                             accelFilter.z * accelFilter.z);
+            float gyroMagnitude = std::sqrt(gyroFilter.x * gyroFilter.x +
+                                            gyroFilter.y * gyroFilter.y +
+                                            gyroFilter.z * gyroFilter.z);
+            float motionEnergy = accelMagnitude + MOTION_GYRO_WEIGHT * gyroMagnitude;
+            if (!motionGate && motionEnergy > MOTION_GATE_ON) {
+                motionGate = true;
+            } else if (motionGate && motionEnergy < MOTION_GATE_OFF) {
+                motionGate = false;
+            }
+            synth.setGate(motionGate);
+
+            // Tilting around x widens the unison detune, around y the
+            // stereo spread: 0..3 rad/s -> 0.15..1, so the stack never
+            // collapses to one voice.
+            float detuneT = std::fmin(std::fabs(gyroFilter.x) / 3.0f, 1.0f);
+            float spreadT = std::fmin(std::fabs(gyroFilter.y) / 3.0f, 1.0f);
+            synth.setUnison(0.15f + 0.85f * detuneT, 0.15f + 0.85f * spreadT);
+
+            // Cutoff is mapped exponentially, so equal motion moves it by
+            // equal musical intervals.
+            float cutoffT;
+            if (FILTER_SOURCE == FILTER_SOURCE_PROX) {
+                float pMin = 0.0f, pMax = 5.0f; // cm; many sensors only report near / far
+                cutoffT = (std::fmin(std::fmax(proxFilter, pMin), pMax) - pMin) / (pMax - pMin);
+            } else {
+                cutoffT = std::fmin(gyroMagnitude / 4.0f, 1.0f); // 0..4 rad/s
+            }
+            synth.setFilter(FILTER_MIN_CUTOFF_HZ *
+                            std::pow(FILTER_MAX_CUTOFF_HZ / FILTER_MIN_CUTOFF_HZ, cutoffT),
+                            FILTER_RESONANCE);
+
+            // A sharp jolt plays CHORD_MODE on the lead pitch.
+            if (gestureArmed && accelPeak > GESTURE_TAP_THRESHOLD) {
+                gestureArmed = false;
+                synth.trigger(std::fabs(leadFrequency), CHORD_MODE, GESTURE_NOTE_GAIN);
+            } else if (!gestureArmed && accelPeak < 0.5f * GESTURE_TAP_THRESHOLD) {
+                gestureArmed = true;
             }
         }
+        accelPeak = 0.0f;
     }
 
-    void render() {
-        glClearColor(0.f, 0.f, 0.f, 1.0f);
-        glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(shaderProgram);
-
-        glEnableVertexAttribArray(vPositionHandle);
-        glVertexAttribPointer(vPositionHandle, 1, GL_FLOAT, GL_FALSE, 0, xPos);
+    void logRenderStats() {
+        const TraceRenderer::Stats &stats = traceRenderer.stats();
+        if (stats.frames < RENDER_STATS_LOG_INTERVAL) return;
+        double frames = double(stats.frames);
+        LOGI("render: %.1f draw calls/frame, %.1f uploads/frame, %.0f upload bytes/frame, "
+             "%llu rendered, %llu skipped",
+             double(stats.drawCalls) / frames, double(stats.uploadCalls) / frames,
+             double(stats.uploadBytes) / frames,
+             (unsigned long long) framesRendered.load(), (unsigned long long) framesSkipped.load());
+        traceRenderer.resetStats();
+    }
 
-        glEnableVertexAttribArray(vSensorValueHandle);
+    // Logs how long the last resume() took to get audio flowing, once the
+    // first block after it has been rendered.
+    void logResumeLatency() {
+        if (!resumeReportPending || firstAudiblePending.load(std::memory_order_acquire)) return;
+        resumeReportPending = false;
+        const AudioOutput::Info info = audioOutput.info();
+        const double bufferedMs = 1000.0 * double(info.periodFrames) * double(info.periods) /
+                                  double(info.sampleRate);
+        LOGI("audio: resumed, device started in %.1f ms, first audible sample rendered %.1f ms "
+             "after resume (+ up to %.1f ms device buffer before it is heard)",
+             resumeStartMs, double(firstAudibleNs.load() - resumeNs) / 1e6, bufferedMs);
+    }
 
-        // --- Accelerometer: X, Y, Z ---
-        glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE,
-                              sizeof(Vec3),
-                              &accelData[accelIndex].x);
-        glUniform4f(uFragColorHandle, 1.0f, 1.0f, 0.0f, 1.0f); // yellow
-        glDrawArrays(GL_LINE_STRIP, 0, SENSOR_HISTORY_LENGTH);
+    // Logs callback timing accumulated since the previous line.
+    void logCallbackStats() {
+        if (!audioInitialized) return;
+        const int64_t nowNs = AudioCallbackStats::now();
+        if (nowNs - callbackStatsLoggedNs < AUDIO_STATS_LOG_INTERVAL_NS) return;
+        AudioCallbackStats::Snapshot total = audioOutput.stats();
+        AudioCallbackStats::Snapshot recent = total.since(loggedCallbackStats);
+        if (recent.callbacks > 0) {
+            LOGI("audio: %llu callbacks, %.0f frames/callback every %.0f us, load mean %.1f%% "
+                 "p50 %d%% p99 %d%%, max %.0f us, %llu late, %llu missed, %d voices, %llu stolen, "
+                 "%llu silent blocks, limiter %.1f dB now %.1f dB max, %llu limited blocks",
+                 (unsigned long long) recent.callbacks,
+                 double(recent.frames) / double(recent.callbacks), recent.meanIntervalUs(),
+                 recent.meanLoadPercent(),
+                 recent.loadPercentile(0.5), recent.loadPercentile(0.99),
+                 double(total.maxElapsedNs) / 1000.0, (unsigned long long) recent.late,
+                 (unsigned long long) recent.missed, synth.activeVoices(),
+                 (unsigned long long) synth.voicesStolen(),
+                 (unsigned long long) synth.silentBlocks(), outputStage.gainReductionDb(),
+                 outputStage.maxGainReductionDb(),
+                 (unsigned long long) outputStage.limitedBlocks());
+        }
+        loggedCallbackStats = total;
+        callbackStatsLoggedNs = nowNs;
+    }
 
-        glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE,
-                              sizeof(Vec3),
-                              &accelData[accelIndex].y);
-        glUniform4f(uFragColorHandle, 1.0f, 0.0f, 1.0f, 1.0f); // magenta
-        glDrawArrays(GL_LINE_STRIP, 0, SENSOR_HISTORY_LENGTH);
+    // GL thread: onDrawFrame. In render-on-demand mode requestFrame() has
+    // already drained the sensors for this vsync.
+    void drawFrame() {
+        if (!sensorsUpdated) update();
+        sensorsUpdated = false;
+        render();
+    }
 
-        glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE,
-                              sizeof(Vec3),
-                              &accelData[accelIndex].z);
-        glUniform4f(uFragColorHandle, 0.0f, 1.0f, 1.0f, 1.0f); // cyan
-        glDrawArrays(GL_LINE_STRIP, 0, SENSOR_HISTORY_LENGTH);
+    void render() {
+        TRACE_SCOPE("render");
+        glClearColor(0.f, 0.f, 0.f, 1.0f);
+        glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-        // --- Gyroscope: X, Y, Z (different tints) ---
-        if (gyroscope) {
-            glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE,
-                                  sizeof(Vec3),
-                                  &gyroData[gyroIndex].x);
-            glUniform4f(uFragColorHandle, 0.6f, 0.6f, 0.0f, 1.0f); // darker yellow
-            glDrawArrays(GL_LINE_STRIP, 0, SENSOR_HISTORY_LENGTH);
-
-            glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE,
-                                  sizeof(Vec3),
-                                  &gyroData[gyroIndex].y);
-            glUniform4f(uFragColorHandle, 0.6f, 0.0f, 0.6f, 1.0f); // darker magenta
-            glDrawArrays(GL_LINE_STRIP, 0, SENSOR_HISTORY_LENGTH);
-
-            glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE,
-                                  sizeof(Vec3),
-                                  &gyroData[gyroIndex].z);
-            glUniform4f(uFragColorHandle, 0.0f, 0.6f, 0.6f, 1.0f); // darker cyan
-            glDrawArrays(GL_LINE_STRIP, 0, SENSOR_HISTORY_LENGTH);
+        {
+            TRACE_SCOPE("spectrum");
+            spectrumRenderer.render(spectrumAnalyzer.history());
+            spectrumDrawn = spectrumRenderer.drawnCount();
+        }
+        {
+            TRACE_SCOPE("traces");
+            traceRenderer.render(histories);
+        }
+        {
+            TRACE_SCOPE("scope");
+            scopeRenderer.render(scopeTap);
+            scopeDrawn = scopeRenderer.drawnCount();
         }
+        framesRendered++;
+        if (firstFramePending) {
+            firstFramePending = false;
+            std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - surfaceCreatedTime;
+            const ProgramCacheStats &cache = programCacheStats();
+            LOGI("first frame %.2f ms after surfaceCreated (program cache: %d hits, %d misses)",
+                 elapsed.count(), cache.hits, cache.misses);
+        }
+        logRenderStats();
+        logCallbackStats();
+        logResumeLatency();
     }
 
+    // Fades the output out and stops the device (it stays configured, so
+    // resume() only restarts the stream), then turns every sensor off.
     void pause() {
+        if (audioInitialized && !audioPaused) {
+            // The fade is fadeBlocks() blocks, which the callback renders
+            // within that much audio plus one device period: one bounded
+            // sleep rather than polling fadedOut().
+            synth.setMuted(true);
+            const AudioOutput::Info info = audioOutput.info();
+            const double fadeSeconds = double(synth.fadeBlocks() * DSP_BLOCK_FRAMES + info.periodFrames) /
+                                       double(info.sampleRate);
+            std::this_thread::sleep_for(std::chrono::duration<double>(fadeSeconds));
+            if (!synth.fadedOut()) LOGI("audio: stopped before the fade-out finished");
+            audioOutput.stop();
+            audioPaused = true;
+            firstAudiblePending.store(false);
+            resumeReportPending = false;
+        }
         if (accelerometerEventQueue && accelerometer) {
             ASensorEventQueue_disableSensor(accelerometerEventQueue, accelerometer);
         }
         if (gyroscopeEventQueue && gyroscope) {
             ASensorEventQueue_disableSensor(gyroscopeEventQueue, gyroscope);
         }
+        if (proximityEventQueue && proximity) {
+            ASensorEventQueue_disableSensor(proximityEventQueue, proximity);
+        }
+        // Nothing draws the spectrum while paused.
+        spectrumAnalyzer.stop();
     }
 
+    // Audio first, as that's what the user notices: the DSP is prewarmed
+    // while the device is still stopped, then the stream restarts with the
+    // output fading in; sensors and the analyzer follow.
     void resume() {
+        renderDirty = true;
+        if (audioInitialized && audioPaused) {
+            resumeNs = AudioCallbackStats::now();
+            synth.prewarm();
+            synth.setMuted(false);
+            firstAudiblePending.store(true, std::memory_order_release);
+            if (audioOutput.start()) {
+                audioPaused = false;
+                resumeStartMs = double(AudioCallbackStats::now() - resumeNs) / 1e6;
+                resumeReportPending = true;
+            } else {
+                firstAudiblePending.store(false);
+            }
+        }
+        if (audioInitialized && !audioPaused) {
+            spectrumAnalyzer.start(spectrumTap, float(audioOutput.info().sampleRate));
+        }
         if (accelerometerEventQueue && accelerometer) {
             ASensorEventQueue_enableSensor(accelerometerEventQueue, accelerometer);
             auto status = ASensorEventQueue_setEventRate(
@@ -474,6 +782,13 @@ public:
             assert(status >= 0);
             (void)status;
         }
+        if (proximityEventQueue && proximity) {
+            ASensorEventQueue_enableSensor(proximityEventQueue, proximity);
+            auto status = ASensorEventQueue_setEventRate(
+                    proximityEventQueue, proximity, SENSOR_REFRESH_PERIOD_US);
+            assert(status >= 0);
+            (void)status;
+        }
     }
 };
 
@@ -482,10 +797,13 @@ sensorgraph gSensorGraph;
 
 extern "C" {
 JNIEXPORT void JNICALL Java_com_example_therecell_MainActivity_init(
-        JNIEnv *env, jobject type, jobject assetManager) {
+        JNIEnv *env, jobject type, jobject assetManager, jstring cacheDir) {
     (void) type;
     AAssetManager *nativeAssetManager = AAssetManager_fromJava(env, assetManager);
-    gSensorGraph.init(nativeAssetManager);
+    const char *cacheDirChars = env->GetStringUTFChars(cacheDir, nullptr);
+    std::string cacheDirPath(cacheDirChars);
+    env->ReleaseStringUTFChars(cacheDir, cacheDirChars);
+    gSensorGraph.init(nativeAssetManager, cacheDirPath);
 }
 
 JNIEXPORT void JNICALL Java_com_example_therecell_MainActivity_surfaceCreated(
@@ -506,8 +824,105 @@ JNIEXPORT void JNICALL
 Java_com_example_therecell_MainActivity_drawFrame(JNIEnv *env, jobject type) {
     (void) env;
     (void) type;
-    gSensorGraph.update();
-    gSensorGraph.render();
+    gSensorGraph.drawFrame();
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_therecell_MainActivity_setDisplayDensity(JNIEnv *env, jobject type,
+                                                          jfloat density) {
+    (void) env;
+    (void) type;
+    gSensorGraph.setDisplayDensity(density);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_therecell_MainActivity_requestFrame(JNIEnv *env, jobject type,
+                                                     jlong frameTimeNanos) {
+    (void) env;
+    (void) type;
+    return gSensorGraph.requestFrame(frameTimeNanos) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_therecell_MainActivity_setSpectrumConfig(JNIEnv *env, jobject type,
+                                                          jint fftSize, jint hop) {
+    (void) env;
+    (void) type;
+    gSensorGraph.setSpectrumConfig(fftSize, hop);
+}
+
+// 0 draws raw sensor samples; 1..SENSOR_HISTORY_LOD_LEVELS draws min/max
+// envelopes spanning 2^level times as long.
+JNIEXPORT void JNICALL
+Java_com_example_therecell_MainActivity_setHistoryLodLevel(JNIEnv *env, jobject type,
+                                                           jint level) {
+    (void) env;
+    (void) type;
+    gSensorGraph.setHistoryLodLevel(level);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_therecell_MainActivity_setMaxFrameRate(JNIEnv *env, jobject type, jint fps) {
+    (void) env;
+    (void) type;
+    gSensorGraph.setMaxFrameRate(fps);
+}
+
+// Returns {frames rendered, frames skipped}.
+JNIEXPORT jlongArray JNICALL
+Java_com_example_therecell_MainActivity_frameStats(JNIEnv *env, jobject type) {
+    (void) type;
+    uint64_t rendered, skipped;
+    gSensorGraph.frameStats(rendered, skipped);
+    const jlong values[2] = {jlong(rendered), jlong(skipped)};
+    jlongArray result = env->NewLongArray(2);
+    env->SetLongArrayRegion(result, 0, 2, values);
+    return result;
+}
+
+// Returns {callbacks, frames, late, missed, mean load in 0.1 %, p99 load %,
+// max callback time in us}, accumulated since the device started, followed
+// by {sample rate, period frames, AUDIO_CONVERSION_* flags} and {mean
+// callback interval in us, LATENCY_PROFILE_*, periods, exclusive, device
+// open time in us} and the limiter's {gain reduction now and deepest since
+// the device started, in 0.01 dB, limited blocks}.
+JNIEXPORT jlongArray JNICALL
+Java_com_example_therecell_MainActivity_audioStats(JNIEnv *env, jobject type) {
+    (void) type;
+    AudioCallbackStats::Snapshot stats = gSensorGraph.audioStats();
+    const AudioOutput::Info info = gSensorGraph.audioInfo();
+    const OutputStage &output = gSensorGraph.output();
+    const jlong values[18] = {
+            jlong(stats.callbacks), jlong(stats.frames), jlong(stats.late), jlong(stats.missed),
+            jlong(stats.meanLoadPercent() * 10.0), jlong(stats.loadPercentile(0.99)),
+            jlong(stats.maxElapsedNs / 1000),
+            jlong(info.sampleRate), jlong(info.periodFrames), jlong(info.conversion),
+            jlong(stats.meanIntervalUs()), jlong(info.profile), jlong(info.periods), jlong(info.exclusive),
+            jlong(info.openMs * 1000.0),
+            jlong(output.gainReductionDb() * 100.0f), jlong(output.maxGainReductionDb() * 100.0f),
+            jlong(output.limitedBlocks())};
+    jlongArray result = env->NewLongArray(18);
+    env->SetLongArrayRegion(result, 0, 18, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_therecell_MainActivity_setLatencyProfile(JNIEnv *env, jobject type,
+                                                          jint profile) {
+    (void) env;
+    (void) type;
+    gSensorGraph.setLatencyProfile(profile);
+}
+
+// Writes the trace timeline as Chrome JSON; false when tracing is compiled
+// out or the file can't be written.
+JNIEXPORT jboolean JNICALL
+Java_com_example_therecell_MainActivity_dumpTrace(JNIEnv *env, jobject type, jstring path) {
+    (void) type;
+    const char *pathChars = env->GetStringUTFChars(path, nullptr);
+    bool written = traceDumpJson(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return written ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT void JNICALL
@@ -524,6 +939,15 @@ Java_com_example_therecell_MainActivity_resume(JNIEnv *env, jobject type) {
     gSensorGraph.resume();
 }
 
+JNIEXPORT void JNICALL
+Java_com_example_therecell_MainActivity_setNativeAudioParams(JNIEnv *env, jobject type,
+                                                             jint sampleRate,
+                                                             jint framesPerBuffer) {
+    (void) env;
+    (void) type;
+    gSensorGraph.setNativeAudioParams(sampleRate, framesPerBuffer);
+}
+
 JNIEXPORT void JNICALL
 Java_com_example_therecell_MainActivity_initAudio(JNIEnv *env, jobject obj) {
     gSensorGraph.initAudio();
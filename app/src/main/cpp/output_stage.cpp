@@ -0,0 +1,101 @@
+#include "output_stage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "simd.h"
+
+namespace {
+
+const float DENORMAL_LEVEL = 1e-15f;
+// Relative margin under the ceiling for float rounding in the gain and the
+// 32-step ramp (a few ulp), so rounding can't put a sample 1 ulp over.
+const float ROUNDING_HEADROOM = 1.0f - 1e-5f;
+
+float peakOf(const float *samples, int count) {
+    float4 peak = splat4(0.0f);
+    for (int i = 0; i < count; i += 4) peak = max4(peak, abs4(load4(samples + i)));
+    return std::max(std::max(peak[0], peak[1]), std::max(peak[2], peak[3]));
+}
+
+float toDb(float gain) {
+    return gain < 1.0f ? -20.0f * std::log10(std::max(gain, 1e-6f)) : 0.0f;
+}
+
+} // namespace
+
+void OutputStage::prepare(float sampleRate) {
+    dcCoefficient = std::exp(-6.2831853f * OUTPUT_DC_CUTOFF_HZ / sampleRate);
+    releaseCoefficient = 1.0f - std::exp(-float(DSP_BLOCK_FRAMES) /
+                                         (OUTPUT_LIMITER_RELEASE_SECONDS * sampleRate));
+    for (int c = 0; c < 2; c++) {
+        dcInput[c] = 0.0f;
+        dcOutput[c] = 0.0f;
+    }
+    gain = 1.0f;
+    delayedPeak = 0.0f;
+    std::memset(delayed, 0, sizeof(delayed));
+    currentGain.store(1.0f);
+    minGain.store(1.0f);
+    limitedBlockCount.store(0);
+}
+
+bool OutputStage::process(float *block) {
+    const bool settled = delayedPeak == 0.0f && dcInput[0] == 0.0f && dcInput[1] == 0.0f &&
+                         dcOutput[0] == 0.0f && dcOutput[1] == 0.0f;
+    if (settled && peakOf(block, SAMPLES) == 0.0f) {
+        // Silence in, silence held back: the block is already the output.
+        gain += releaseCoefficient * (1.0f - gain);
+        currentGain.store(gain, std::memory_order_relaxed);
+        return false;
+    }
+
+    // DC blocker: y[n] = x[n] - x[n-1] + R y[n-1].
+    for (int c = 0; c < 2; c++) {
+        float x1 = dcInput[c];
+        float y1 = dcOutput[c];
+        for (int f = 0; f < DSP_BLOCK_FRAMES; f++) {
+            const float x = block[2 * f + c];
+            y1 = x - x1 + dcCoefficient * y1;
+            x1 = x;
+            block[2 * f + c] = y1;
+        }
+        dcInput[c] = x1;
+        dcOutput[c] = std::fabs(y1) < DENORMAL_LEVEL ? 0.0f : y1;
+    }
+
+    // The ramp over the delayed block ends at a gain safe for both it and
+    // the block coming in; it started at one already safe for the delayed
+    // block, so every sample in between is within the ceiling.
+    const float incomingPeak = peakOf(block, SAMPLES);
+    const float peak = std::max(delayedPeak, incomingPeak);
+    float target = peak > OUTPUT_CEILING ? OUTPUT_CEILING * ROUNDING_HEADROOM / peak : 1.0f;
+    if (target > gain) target = gain + releaseCoefficient * (target - gain);
+
+    // Two frames (four samples) per step.
+    const float step = (target - gain) / float(DSP_BLOCK_FRAMES);
+    float4 ramp = {gain + step, gain + step, gain + 2.0f * step, gain + 2.0f * step};
+    const float4 rampStep = splat4(2.0f * step);
+    for (int i = 0; i < SAMPLES; i += 4) {
+        const float4 in = load4(block + i);
+        store4(block + i, load4(delayed + i) * ramp);
+        store4(delayed + i, in);
+        ramp += rampStep;
+    }
+
+    if (target < 1.0f) limitedBlockCount.fetch_add(1, std::memory_order_relaxed);
+    gain = target;
+    delayedPeak = incomingPeak;
+    currentGain.store(gain, std::memory_order_relaxed);
+    if (gain < minGain.load(std::memory_order_relaxed)) minGain.store(gain, std::memory_order_relaxed);
+    return true;
+}
+
+float OutputStage::gainReductionDb() const {
+    return toDb(currentGain.load(std::memory_order_relaxed));
+}
+
+float OutputStage::maxGainReductionDb() const {
+    return toDb(minGain.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "block_adapter.h"
+
+const float OUTPUT_CEILING = 0.944f;              // -0.5 dBFS; nothing leaves louder than this
+const float OUTPUT_DC_CUTOFF_HZ = 10.0f;
+const float OUTPUT_LIMITER_RELEASE_SECONDS = 0.1f;
+
+/*
+ * OutputStage
+ *    The last thing before the device: a DC blocker, then a peak limiter
+ *    with one DSP_BLOCK_FRAMES block of lookahead. Each block is held back
+ *    one block in a preallocated delay line while its peak is found (four
+ *    lanes at a time); the previous block then goes out with a gain ramp
+ *    ending low enough for both blocks. Both ends of every ramp are at or
+ *    below OUTPUT_CEILING / peak for the block it scales, so no sample can
+ *    exceed the ceiling, at a fixed cost of DSP_BLOCK_FRAMES frames of
+ *    latency. Gain comes back up over OUTPUT_LIMITER_RELEASE_SECONDS.
+ *
+ *    Silence in with nothing held back costs one peak search. prepare()
+ *    while the device is stopped; process() on the audio thread; the
+ *    gain reduction getters from any thread.
+ */
+class OutputStage {
+public:
+    // Clears the delay line and filter state.
+    void prepare(float sampleRate);
+
+    // Processes one DSP_BLOCK_FRAMES interleaved stereo block in place;
+    // false when it went out as silence with nothing held back.
+    bool process(float *block);
+
+    // Current gain reduction, dB (>= 0).
+    float gainReductionDb() const;
+
+    // Deepest gain reduction since prepare(), dB.
+    float maxGainReductionDb() const;
+
+    // Blocks that went out with the gain below unity, since prepare().
+    uint64_t limitedBlocks() const { return limitedBlockCount.load(std::memory_order_relaxed); }
+
+private:
+    static const int SAMPLES = 2 * DSP_BLOCK_FRAMES;
+
+    float dcCoefficient = 0.999f;
+    float dcInput[2] = {0.0f, 0.0f};
+    float dcOutput[2] = {0.0f, 0.0f};
+
+    float releaseCoefficient = 1.0f; // per block
+    float gain = 1.0f;
+    float delayedPeak = 0.0f;
+    alignas(DSP_BLOCK_ALIGNMENT) float delayed[SAMPLES];
+
+    std::atomic<float> currentGain{1.0f};
+    std::atomic<float> minGain{1.0f};
+    std::atomic<uint64_t> limitedBlockCount{0};
+};
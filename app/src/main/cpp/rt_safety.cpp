@@ -0,0 +1,296 @@
+// Only built with THERECELL_RT_SAFETY_CHECK on Linux, into the host
+// rt_safety_test; see rt_safety.h. Interposition relies on the executable
+// being searched before libc, which holds for glibc but not for libraries
+// that Android loads with System.loadLibrary().
+
+// The fortified inline fprintf / vfprintf would clash with the definitions
+// below; the __*_chk entry points they call are interposed instead.
+#undef _FORTIFY_SOURCE
+
+#include "rt_safety.h"
+
+#if !THERECELL_RT_SAFETY_CHECK || defined(__ANDROID__) || !defined(__linux__)
+#error "rt_safety.cpp is a Linux-only debug facility"
+#endif
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const int RT_SAFETY_MAX_REPORTS = 16;
+
+namespace {
+
+typedef void *(*MallocFn)(size_t);
+typedef void *(*CallocFn)(size_t, size_t);
+typedef void *(*ReallocFn)(void *, size_t);
+typedef void (*FreeFn)(void *);
+typedef int (*PosixMemalignFn)(void **, size_t, size_t);
+typedef void *(*AlignedAllocFn)(size_t, size_t);
+typedef int (*MutexLockFn)(pthread_mutex_t *);
+typedef int (*CondWaitFn)(pthread_cond_t *, pthread_mutex_t *);
+typedef int (*CondTimedWaitFn)(pthread_cond_t *, pthread_mutex_t *, const struct timespec *);
+typedef int (*JoinFn)(pthread_t, void **);
+typedef int (*NanosleepFn)(const struct timespec *, struct timespec *);
+typedef int (*UsleepFn)(useconds_t);
+typedef unsigned int (*SleepFn)(unsigned int);
+typedef ssize_t (*ReadFn)(int, void *, size_t);
+typedef ssize_t (*WriteFn)(int, const void *, size_t);
+typedef int (*VfprintfFn)(FILE *, const char *, va_list);
+typedef int (*VfprintfChkFn)(FILE *, int, const char *, va_list);
+
+struct RealFunctions {
+    MallocFn malloc;
+    CallocFn calloc;
+    ReallocFn realloc;
+    FreeFn free;
+    PosixMemalignFn posixMemalign;
+    AlignedAllocFn alignedAlloc;
+    MutexLockFn mutexLock;
+    CondWaitFn condWait;
+    CondTimedWaitFn condTimedWait;
+    JoinFn join;
+    NanosleepFn nanosleep;
+    UsleepFn usleep;
+    SleepFn sleep;
+    ReadFn read;
+    WriteFn write;
+    VfprintfFn vfprintf;
+    VfprintfChkFn vfprintfChk;
+};
+
+RealFunctions real;
+std::atomic<bool> resolving{false};
+std::atomic<uint64_t> violations{0};
+bool abortOnViolation = false;
+
+// Initial-exec TLS: the default model may allocate on first access.
+__attribute__((tls_model("initial-exec"))) thread_local int realtimeDepth = 0;
+__attribute__((tls_model("initial-exec"))) thread_local bool reporting = false;
+
+// dlsym() can allocate while the real allocator is still unknown; those
+// few early requests are served from here and never freed.
+alignas(16) char bootstrapArena[16384];
+std::atomic<size_t> bootstrapUsed{0};
+
+void *bootstrapAlloc(size_t size) {
+    size = (size + 15) & ~size_t(15);
+    size_t offset = bootstrapUsed.fetch_add(size);
+    if (offset + size > sizeof(bootstrapArena)) abort();
+    return bootstrapArena + offset;
+}
+
+bool isBootstrap(const void *p) {
+    return p >= bootstrapArena && p < bootstrapArena + sizeof(bootstrapArena);
+}
+
+// version pins symbols that glibc also exports in an older, incompatible
+// form (pthread_cond_* before 2.3.2); architectures without the old form
+// only have the unversioned one.
+template<typename Fn>
+void lookup(Fn &fn, const char *name, const char *version = nullptr) {
+#ifdef __GLIBC__
+    if (version) fn = (Fn) dlvsym(RTLD_NEXT, name, version);
+#endif
+    if (!fn) fn = (Fn) dlsym(RTLD_NEXT, name);
+}
+
+void resolve() {
+    if (real.malloc || resolving.exchange(true)) return;
+    lookup(real.calloc, "calloc");
+    lookup(real.realloc, "realloc");
+    lookup(real.free, "free");
+    lookup(real.posixMemalign, "posix_memalign");
+    lookup(real.alignedAlloc, "aligned_alloc");
+    lookup(real.mutexLock, "pthread_mutex_lock");
+    lookup(real.condWait, "pthread_cond_wait", "GLIBC_2.3.2");
+    lookup(real.condTimedWait, "pthread_cond_timedwait", "GLIBC_2.3.2");
+    lookup(real.join, "pthread_join");
+    lookup(real.nanosleep, "nanosleep");
+    lookup(real.usleep, "usleep");
+    lookup(real.sleep, "sleep");
+    lookup(real.read, "read");
+    lookup(real.write, "write");
+    lookup(real.vfprintf, "vfprintf");
+    lookup(real.vfprintfChk, "__vfprintf_chk");
+    lookup(real.malloc, "malloc"); // last: non-null marks the table complete
+}
+
+// The real function, resolving the table if this is the first call into
+// the checker: a static constructor can sleep or print before anything
+// has allocated. If another thread is mid-resolve, looks this one up alone.
+template<typename Fn>
+Fn next(Fn &fn, const char *name, const char *version = nullptr) {
+    if (!fn) resolve();
+    if (!fn) lookup(fn, name, version);
+    return fn;
+}
+
+__attribute__((constructor)) void initialize() {
+    resolve();
+    const char *abortEnv = getenv("THERECELL_RT_SAFETY_ABORT");
+    abortOnViolation = abortEnv != nullptr && strcmp(abortEnv, "1") == 0;
+    // backtrace() loads libgcc on first use; do that outside any callback.
+    void *frame;
+    backtrace(&frame, 1);
+}
+
+void report(const char *what) {
+    if (realtimeDepth == 0 || reporting) return;
+    reporting = true;
+    uint64_t count = violations.fetch_add(1) + 1;
+    if (count <= uint64_t(RT_SAFETY_MAX_REPORTS)) {
+        char line[160];
+        int length = snprintf(line, sizeof(line),
+                              "rt-safety: %s called inside the audio callback (#%llu)\n",
+                              what, (unsigned long long) count);
+        if (length > 0 && real.write) real.write(STDERR_FILENO, line, size_t(length));
+        void *frames[32];
+        int depth = backtrace(frames, 32);
+        backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+    }
+    if (abortOnViolation) abort();
+    reporting = false;
+}
+
+} // namespace
+
+void rtSafetyEnter() { realtimeDepth++; }
+
+void rtSafetyLeave() { realtimeDepth--; }
+
+uint64_t rtSafetyViolations() { return violations.load(); }
+
+extern "C" {
+
+void *malloc(size_t size) noexcept {
+    if (!real.malloc) {
+        resolve();
+        if (!real.malloc) return bootstrapAlloc(size);
+    }
+    report("malloc");
+    return real.malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+    if (!real.calloc) {
+        resolve();
+        if (!real.calloc) return bootstrapAlloc(count * size); // arena is zeroed
+    }
+    report("calloc");
+    return real.calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) noexcept {
+    report("realloc");
+    if (isBootstrap(p)) {
+        void *moved = malloc(size);
+        size_t available = size_t(bootstrapArena + sizeof(bootstrapArena) - (char *) p);
+        if (moved) memcpy(moved, p, size < available ? size : available);
+        return moved;
+    }
+    return next(real.realloc, "realloc")(p, size);
+}
+
+void free(void *p) noexcept {
+    if (p == nullptr || isBootstrap(p)) return;
+    report("free");
+    next(real.free, "free")(p);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) noexcept {
+    report("posix_memalign");
+    return next(real.posixMemalign, "posix_memalign")(out, alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept {
+    report("aligned_alloc");
+    return next(real.alignedAlloc, "aligned_alloc")(alignment, size);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept {
+    report("pthread_mutex_lock");
+    return next(real.mutexLock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+    report("pthread_cond_wait");
+    return next(real.condWait, "pthread_cond_wait", "GLIBC_2.3.2")(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                           const struct timespec *deadline) {
+    report("pthread_cond_timedwait");
+    return next(real.condTimedWait, "pthread_cond_timedwait", "GLIBC_2.3.2")(cond, mutex, deadline);
+}
+
+int pthread_join(pthread_t thread, void **result) {
+    report("pthread_join");
+    return next(real.join, "pthread_join")(thread, result);
+}
+
+int nanosleep(const struct timespec *duration, struct timespec *remaining) {
+    report("nanosleep");
+    return next(real.nanosleep, "nanosleep")(duration, remaining);
+}
+
+int usleep(useconds_t micros) {
+    report("usleep");
+    return next(real.usleep, "usleep")(micros);
+}
+
+unsigned int sleep(unsigned int seconds) {
+    report("sleep");
+    return next(real.sleep, "sleep")(seconds);
+}
+
+ssize_t read(int fd, void *buffer, size_t length) {
+    report("read");
+    return next(real.read, "read")(fd, buffer, length);
+}
+
+ssize_t write(int fd, const void *buffer, size_t length) {
+    report("write");
+    return next(real.write, "write")(fd, buffer, length);
+}
+
+// Covers LOGI on non-Android builds, which prints through fprintf.
+int vfprintf(FILE *stream, const char *format, va_list args) {
+    report("vfprintf");
+    return next(real.vfprintf, "vfprintf")(stream, format, args);
+}
+
+int fprintf(FILE *stream, const char *format, ...) {
+    report("fprintf");
+    va_list args;
+    va_start(args, format);
+    int result = next(real.vfprintf, "vfprintf")(stream, format, args);
+    va_end(args);
+    return result;
+}
+
+// With _FORTIFY_SOURCE the compiler turns fprintf / vfprintf into these, so
+// fortified builds of LOGI never reach the two above.
+int __vfprintf_chk(FILE *stream, int flag, const char *format, va_list args) {
+    report("__vfprintf_chk");
+    return next(real.vfprintfChk, "__vfprintf_chk")(stream, flag, format, args);
+}
+
+int __fprintf_chk(FILE *stream, int flag, const char *format, ...) {
+    report("__fprintf_chk");
+    va_list args;
+    va_start(args, format);
+    int result = next(real.vfprintfChk, "__vfprintf_chk")(stream, flag, format, args);
+    va_end(args);
+    return result;
+}
+
+} // extern "C"
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Real-time safety checker (Linux, THERECELL_RT_SAFETY_CHECK)
+ *    rt_safety.cpp interposes the allocator, pthread mutex / condition
+ *    waits, sleeps, read / write and stdio printing (fortified or not). Any
+ *    of them called on a thread that is inside an RT_SAFETY_SCOPE() is
+ *    reported on stderr with a backtrace (the first RT_SAFETY_MAX_REPORTS
+ *    times) and counted. Setting THERECELL_RT_SAFETY_ABORT=1 in the
+ *    environment aborts on the first violation instead.
+ *
+ *    tests/rt_safety_test builds audio_output.cpp and rt_safety.cpp with
+ *    the check on and fails if rendering on the null backend trips it.
+ *    Everywhere else RT_SAFETY_SCOPE() compiles to nothing.
+ */
+#if THERECELL_RT_SAFETY_CHECK
+
+void rtSafetyEnter();
+void rtSafetyLeave();
+uint64_t rtSafetyViolations();
+
+struct RealtimeScope {
+    RealtimeScope() { rtSafetyEnter(); }
+    ~RealtimeScope() { rtSafetyLeave(); }
+    RealtimeScope(const RealtimeScope &) = delete;
+    RealtimeScope &operator=(const RealtimeScope &) = delete;
+};
+
+#define RT_SAFETY_SCOPE() RealtimeScope rtSafetyScope
+
+#else
+
+#define RT_SAFETY_SCOPE() do {} while (0)
+
+inline uint64_t rtSafetyViolations() { return 0; }
+
+#endif
@@ -0,0 +1,100 @@
+#include "scope_renderer.h"
+
+#include <cassert>
+
+#include "gl_program.h"
+
+namespace {
+
+// Latest rising zero crossing at or before lastIndex, as a fractional sample
+// position in [index - 1, index); returns -1 when the signal never armed.
+float findTrigger(const float *samples, int lastIndex) {
+    bool armed = samples[0] < -SCOPE_TRIGGER_HYSTERESIS;
+    float trigger = -1.0f;
+    for (int i = 1; i <= lastIndex; i++) {
+        if (armed && samples[i - 1] < 0.0f && samples[i] >= 0.0f) {
+            trigger = float(i - 1) + samples[i - 1] / (samples[i - 1] - samples[i]);
+            armed = false;
+        } else if (samples[i] < -SCOPE_TRIGGER_HYSTERESIS) {
+            armed = true;
+        }
+    }
+    return trigger;
+}
+
+} // namespace
+
+ScopeRenderer::ScopeRenderer() {
+    for (int i = 0; i < STRIP_POINTS; i++) {
+        columns[i] = GLfloat(i);
+    }
+}
+
+void ScopeRenderer::surfaceCreated(std::string_view vertexSource,
+                                   std::string_view fragmentSource) {
+    shaderProgram = createProgram(vertexSource, fragmentSource);
+    assert(shaderProgram != 0);
+    GLint getColumnLocationResult = glGetAttribLocation(shaderProgram, "vColumn");
+    assert(getColumnLocationResult != -1);
+    vColumnHandle = (GLuint) getColumnLocationResult;
+    GLint getSampleLocationResult = glGetAttribLocation(shaderProgram, "vSample");
+    assert(getSampleLocationResult != -1);
+    vSampleHandle = (GLuint) getSampleLocationResult;
+    uColumnScaleHandle = glGetUniformLocation(shaderProgram, "uColumnScale");
+    assert(uColumnScaleHandle != -1);
+    uOffsetHandle = glGetUniformLocation(shaderProgram, "uOffset");
+    assert(uOffsetHandle != -1);
+    uColorHandle = glGetUniformLocation(shaderProgram, "uColor");
+    assert(uColorHandle != -1);
+
+    glUseProgram(shaderProgram);
+    glUniform1f(uColumnScaleHandle, 2.0f / GLfloat(SCOPE_WINDOW - 1));
+    glUniform4f(uColorHandle, 0.2f, 1.0f, 0.2f, 1.0f); // green
+
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    columnBuffer = buffers[0];
+    sampleBuffer = buffers[1];
+
+    glBindBuffer(GL_ARRAY_BUFFER, columnBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(columns), columns, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, sampleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, STRIP_POINTS * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // New buffers are empty; upload on the next render.
+    drawn = UINT64_MAX;
+}
+
+void ScopeRenderer::render(const OutputScopeTap &tap) {
+    glUseProgram(shaderProgram);
+    glBindBuffer(GL_ARRAY_BUFFER, sampleBuffer);
+
+    if (tap.count() != drawn) {
+        drawn = tap.snapshot(snapshot, SNAPSHOT_LENGTH);
+        // The strip spans STRIP_POINTS samples from the sample before the
+        // crossing, which must still fit in the snapshot.
+        float trigger = findTrigger(snapshot, SNAPSHOT_LENGTH - STRIP_POINTS);
+        int start = SNAPSHOT_LENGTH - STRIP_POINTS;
+        offset = 0.0f;
+        if (trigger >= 0.0f) {
+            start = int(trigger);
+            offset = trigger - GLfloat(start);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, STRIP_POINTS * sizeof(GLfloat), snapshot + start);
+    }
+    glUniform1f(uOffsetHandle, offset);
+
+    glEnableVertexAttribArray(vSampleHandle);
+    glVertexAttribPointer(vSampleHandle, 1, GL_FLOAT, GL_FALSE, 0, (const void *) 0);
+    glBindBuffer(GL_ARRAY_BUFFER, columnBuffer);
+    glEnableVertexAttribArray(vColumnHandle);
+    glVertexAttribPointer(vColumnHandle, 1, GL_FLOAT, GL_FALSE, 0, (const void *) 0);
+
+    glDrawArrays(GL_LINE_STRIP, 0, STRIP_POINTS);
+
+    glDisableVertexAttribArray(vColumnHandle);
+    glDisableVertexAttribArray(vSampleHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
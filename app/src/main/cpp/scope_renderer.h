@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+#include <string_view>
+
+#include "scope_tap.h"
+
+const int SCOPE_TAP_LENGTH = 2048;  // decimated samples, power of two
+const int SCOPE_DECIMATION = 4;     // 48 kHz output -> 12 kHz tap
+const int SCOPE_WINDOW = 256;       // samples drawn (~21 ms at 12 kHz)
+// Rising zero crossings only count after the signal dipped below -hysteresis.
+const float SCOPE_TRIGGER_HYSTERESIS = 0.01f;
+
+using OutputScopeTap = ScopeTap<SCOPE_TAP_LENGTH, SCOPE_DECIMATION>;
+
+/*
+ * ScopeRenderer
+ *    Draws the newest SCOPE_WINDOW samples of an OutputScopeTap as one
+ *    GL_LINE_STRIP over the sensor traces. The window starts at the latest
+ *    rising zero crossing that still leaves a full window after it, with
+ *    sub-sample interpolation, so periodic output stands still; without a
+ *    trigger it free-runs on the newest samples. ES 2.0 only.
+ */
+class ScopeRenderer {
+public:
+    ScopeRenderer();
+
+    // (Re)creates all GL objects; call whenever a new context is current.
+    void surfaceCreated(std::string_view vertexSource, std::string_view fragmentSource);
+
+    void render(const OutputScopeTap &tap);
+
+    // Tap write count of the last drawn window.
+    uint64_t drawnCount() const { return drawn; }
+
+private:
+    // One extra sample so the strip still reaches the right edge when the
+    // trigger point is shifted by a fraction of a sample.
+    static constexpr int STRIP_POINTS = SCOPE_WINDOW + 1;
+    static constexpr int SNAPSHOT_LENGTH = SCOPE_WINDOW * 2;
+
+    GLuint shaderProgram = 0;
+    GLuint vColumnHandle = 0;
+    GLuint vSampleHandle = 0;
+    GLint uColumnScaleHandle = -1;
+    GLint uOffsetHandle = -1;
+    GLint uColorHandle = -1;
+
+    GLuint columnBuffer = 0;
+    GLuint sampleBuffer = 0;
+
+    GLfloat columns[STRIP_POINTS];
+    float snapshot[SNAPSHOT_LENGTH];
+    uint64_t drawn = 0;
+    GLfloat offset = 0.0f;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * ScopeTap<N, Decimation>
+ *    Wait-free single-producer ring that the audio callback writes decimated
+ *    output into, for display on the GL thread. write() keeps channel 0 of
+ *    every Decimation-th interleaved frame, so its cost is bounded by
+ *    frameCount / Decimation stores plus one release store; it never locks,
+ *    allocates or waits on the reader.
+ *
+ *    Storage is mirrored like HistoryRing, so any run of the last N samples
+ *    is contiguous. The reader copies out with snapshot() and retries only
+ *    if the writer got far enough ahead to overwrite what was being copied.
+ */
+template<std::size_t N, std::size_t Decimation>
+class ScopeTap {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "ScopeTap length must be a power of two");
+    static_assert(Decimation > 0, "ScopeTap decimation must be at least 1");
+
+public:
+    static constexpr std::size_t kLength = N;
+    static constexpr std::size_t kMask = N - 1;
+    static constexpr std::size_t kDecimation = Decimation;
+
+    // Audio thread only.
+    void write(const float *frames, uint32_t frameCount, uint32_t channels) {
+        uint64_t count = written.load(std::memory_order_relaxed);
+        std::size_t slot = std::size_t(count) & kMask;
+        uint32_t f = phase;
+        for (; f < frameCount; f += Decimation) {
+            const float sample = frames[std::size_t(f) * channels];
+            data[slot] = sample;
+            data[slot + N] = sample;
+            slot = (slot + 1) & kMask;
+            count++;
+        }
+        // Carry the decimation phase into the next callback.
+        phase = f - frameCount;
+        written.store(count, std::memory_order_release);
+    }
+
+    uint64_t count() const { return written.load(std::memory_order_acquire); }
+
+    // Copies the newest length samples (length <= N / 2) into out, oldest
+    // first, from any thread; returns the write count they end at. Assumes
+    // one callback produces fewer than N / 2 samples, which holds for any
+    // realistic buffer size at these lengths.
+    uint64_t snapshot(float *out, std::size_t length) const {
+        for (;;) {
+            uint64_t before = written.load(std::memory_order_acquire);
+            const float *src = &data[(std::size_t(before) - length) & kMask];
+            for (std::size_t i = 0; i < length; i++) out[i] = src[i];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = written.load(std::memory_order_relaxed);
+            if (after - before < N / 2 - length + 1) return before;
+        }
+    }
+
+private:
+    float data[N * 2]{};
+    std::atomic<uint64_t> written{0};
+    uint32_t phase = 0; // writer only
+};
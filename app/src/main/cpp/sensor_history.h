@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "history_ring.h"
+#include "lod_history.h"
+
+const int SENSOR_HISTORY_LENGTH = 128; // must be a power of two
+// Min/max levels kept alongside the raw history; level k spans
+// SENSOR_HISTORY_LENGTH * 2^k samples (level 9 is several minutes).
+const int SENSOR_HISTORY_LOD_LEVELS = 9;
+
+using SensorHistory = SoAHistoryRing<float, 3, SENSOR_HISTORY_LENGTH>;
+using ScalarHistory = HistoryRing<float, SENSOR_HISTORY_LENGTH>;
+using SensorLod = MinMaxPyramid<SENSOR_HISTORY_LENGTH, SENSOR_HISTORY_LOD_LEVELS>;
+
+/*
+ * SensorHistories
+ *    Filtered sensor values written by the sensor path and drawn by
+ *    TraceRenderer. Nothing in here depends on Android, so the renderer can
+ *    be driven with synthetic data.
+ *
+ *    lodLevel() is the level TraceRenderer draws: 0 draws raw samples,
+ *    1..SENSOR_HISTORY_LOD_LEVELS the min/max envelope with
+ *    2 * SENSOR_HISTORY_LENGTH vertices. The pyramids are fed from the
+ *    first time a level above 0 is chosen, so raw-only use doesn't pay for
+ *    them and switching back and forth later leaves no gaps. Both are for
+ *    the writer thread, which is also the one drawing.
+ */
+struct SensorHistories {
+    SensorHistory accel;
+    SensorLod accelLod[3];
+    SensorHistory gyro;
+    SensorLod gyroLod[3];
+    ScalarHistory prox;
+    SensorLod proxLod;
+    bool hasGyro = false;
+    bool hasProx = false;
+
+    void setLodLevel(int level) {
+        lod = level < 0 ? 0 : level > SENSOR_HISTORY_LOD_LEVELS ? SENSOR_HISTORY_LOD_LEVELS : level;
+        lodFed = lodFed || lod > 0;
+    }
+
+    int lodLevel() const { return lod; }
+
+    // Samples of one sensor across the trace at the current level.
+    uint64_t visibleSamples() const { return uint64_t(SENSOR_HISTORY_LENGTH) << lod; }
+
+    void pushAccel(const float *sample) {
+        accel.push(sample);
+        if (!lodFed) return;
+        for (int c = 0; c < 3; c++) accelLod[c].push(sample[c]);
+    }
+
+    void pushGyro(const float *sample) {
+        gyro.push(sample);
+        if (!lodFed) return;
+        for (int c = 0; c < 3; c++) gyroLod[c].push(sample[c]);
+    }
+
+    void pushProx(float value) {
+        prox.push(value);
+        if (!lodFed) return;
+        proxLod.push(value);
+    }
+
+private:
+    int lod = 0;
+    bool lodFed = false;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/*
+ * float4 / int4
+ *    Four-lane vectors through the GCC / Clang vector extension, so the
+ *    same source compiles to NEON on arm64-v8a and armeabi-v7a and to SSE
+ *    on x86 / x86_64 and host builds. Used where a loop runs across voices
+ *    or unison lanes (structure-of-arrays state, four lanes at a time) and
+ *    has to sum lanes into one output, which the auto-vectoriser won't do
+ *    for floats without -ffast-math. Lane arrays are padded to a multiple
+ *    of four and 16-byte aligned.
+ */
+typedef float float4 __attribute__((vector_size(16)));
+typedef int32_t int4 __attribute__((vector_size(16)));
+
+inline float4 load4(const float *p) {
+    float4 v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void store4(float *p, float4 v) { std::memcpy(p, &v, sizeof(v)); }
+
+inline float4 splat4(float x) { return float4{x, x, x, x}; }
+
+// Lanes of a where mask is all ones, of b where it is zero.
+inline float4 select4(int4 mask, float4 a, float4 b) {
+    return (float4) ((mask & (int4) a) | (~mask & (int4) b));
+}
+
+inline float4 min4(float4 a, float4 b) { return select4(a < b, a, b); }
+
+inline float4 max4(float4 a, float4 b) { return select4(a > b, a, b); }
+
+inline float4 abs4(float4 a) { return (float4) ((int4) a & int4{0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff}); }
+
+// x - floor(x), for x > -2^23.
+inline float4 fract4(float4 x) {
+    float4 t = __builtin_convertvector(__builtin_convertvector(x, int4), float4);
+    return x - select4(t > x, t - 1.0f, t);
+}
+
+inline float hsum4(float4 v) { return (v[0] + v[1]) + (v[2] + v[3]); }
+
+// sin(2 pi phase) for phase in [0, 1): folded to a quarter turn and
+// evaluated as a degree-9 odd polynomial (|error| < 4e-6).
+inline float4 sinTurns4(float4 phase) {
+    const float twoPi = 6.28318530718f;
+    float4 x = phase - 0.5f;                          // sin(2 pi phase) = -sin(2 pi x)
+    float4 a = abs4(x);
+    float4 folded = select4(a > 0.25f, 0.5f - a, a);  // sin(pi - t) = sin(t)
+    float4 signBit = (float4) ((int4) x & int4{INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN});
+    float4 z = twoPi * (float4) ((int4) folded | (int4) signBit);
+    float4 z2 = z * z;
+    float4 p = splat4(1.0f / 362880.0f);
+    p = p * z2 - 1.0f / 5040.0f;
+    p = p * z2 + 1.0f / 120.0f;
+    p = p * z2 - 1.0f / 6.0f;
+    p = p * z2 + 1.0f;
+    return -(z * p);
+}
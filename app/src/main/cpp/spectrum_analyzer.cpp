@@ -0,0 +1,100 @@
+#include "spectrum_analyzer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "trace_events.h"
+
+void SpectrumAnalyzer::configure(int size, int hopSamples) {
+    size = std::clamp(size, SPECTRUM_MIN_FFT_SIZE, SPECTRUM_MAX_FFT_SIZE);
+    while (size & (size - 1)) size &= size - 1;
+    requestedFftSize = size;
+    requestedHop = std::clamp(hopSamples, 1, size);
+}
+
+void SpectrumAnalyzer::start(const SpectrumTap &tap, float sampleRate) {
+    if (running) return;
+    source = &tap;
+    rate = sampleRate;
+    fftSize = 0; // rebuilt for the current rate on the worker
+    running = true;
+    worker = std::thread(&SpectrumAnalyzer::run, this);
+}
+
+void SpectrumAnalyzer::stop() {
+    if (!running) return;
+    running = false;
+    worker.join();
+}
+
+void SpectrumAnalyzer::run() {
+    TRACE_THREAD_NAME("spectrum");
+    uint64_t analyzed = source->count();
+    while (running.load(std::memory_order_relaxed)) {
+        if (fftSize != requestedFftSize.load() || hop != requestedHop.load()) {
+            hop = requestedHop.load();
+            rebuild(requestedFftSize.load());
+        }
+        if (source->count() - analyzed >= uint64_t(hop)) {
+            analyze(analyzed);
+        } else {
+            // Nothing to do for roughly half a hop; the callback never waits on us.
+            auto idle = std::chrono::microseconds(int64_t(5e5f * float(hop) / rate));
+            std::this_thread::sleep_for(std::max(idle, std::chrono::microseconds(1000)));
+        }
+    }
+}
+
+void SpectrumAnalyzer::rebuild(int size) {
+    const double twoPi = 6.283185307179586;
+    fftSize = size;
+    fft = std::make_unique<RealFft>(size);
+    window.resize(size);
+    for (int i = 0; i < size; i++) {
+        window[i] = float(0.5 - 0.5 * std::cos(twoPi * i / size));
+    }
+    samples.resize(size);
+    re.resize(fft->bins());
+    im.resize(fft->bins());
+
+    // Band edges spaced evenly in log frequency from SPECTRUM_MIN_HZ to Nyquist.
+    const float binHz = rate / float(size);
+    const float nyquist = 0.5f * rate;
+    bandStart.resize(SPECTRUM_BINS + 1);
+    for (int b = 0; b <= SPECTRUM_BINS; b++) {
+        float hz = SPECTRUM_MIN_HZ * std::pow(nyquist / SPECTRUM_MIN_HZ, float(b) / SPECTRUM_BINS);
+        bandStart[b] = std::min(int(hz / binHz), size / 2);
+    }
+}
+
+void SpectrumAnalyzer::analyze(uint64_t &analyzed) {
+    TRACE_SCOPE("analyze");
+    analyzed = source->snapshot(samples.data(), size_t(fftSize));
+    float levels[SPECTRUM_BINS];
+    if (std::all_of(samples.begin(), samples.end(), [](float s) { return s == 0.0f; })) {
+        std::fill(levels, levels + SPECTRUM_BINS, 0.0f);
+        spectra.push(levels);
+        return;
+    }
+    for (int i = 0; i < fftSize; i++) samples[i] *= window[i];
+    fft->forward(samples.data(), re.data(), im.data());
+
+    // A full-scale sine peaks at |X| = fftSize / 4 under a Hann window.
+    const float scale = 4.0f / float(fftSize);
+    bool audible = false;
+    for (int b = 0; b < SPECTRUM_BINS; b++) {
+        // Low bands can be narrower than one FFT bin; they share its level.
+        int first = bandStart[b];
+        int last = std::max(bandStart[b + 1], first + 1);
+        float peak = 0.0f;
+        for (int k = first; k < last; k++) {
+            peak = std::max(peak, re[k] * re[k] + im[k] * im[k]);
+        }
+        float db = 10.0f * std::log10(peak * scale * scale + 1e-20f);
+        levels[b] = std::clamp(1.0f - db / SPECTRUM_FLOOR_DB, 0.0f, 1.0f);
+        audible = audible || levels[b] > 0.0f;
+    }
+    spectra.push(levels);
+    if (audible) audibleFrames.store(spectra.count(), std::memory_order_relaxed);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "fft.h"
+#include "history_ring.h"
+#include "scope_tap.h"
+
+const int SPECTRUM_TAP_LENGTH = 16384; // full-rate output samples, power of two
+const int SPECTRUM_MIN_FFT_SIZE = 256;
+const int SPECTRUM_MAX_FFT_SIZE = SPECTRUM_TAP_LENGTH / 2;
+const int SPECTRUM_BINS = 128;         // log-spaced display bands
+const int SPECTRUM_ROWS = 256;         // spectra kept for the spectrogram, power of two
+const float SPECTRUM_MIN_HZ = 40.0f;
+const float SPECTRUM_FLOOR_DB = -90.0f; // maps to 0; 0 dBFS maps to 1
+
+using SpectrumTap = ScopeTap<SPECTRUM_TAP_LENGTH, 1>;
+// One channel per display band, one ring slot per analysed frame; each
+// value is the band level normalised to 0..1.
+using SpectrumHistory = SoAHistoryRing<float, SPECTRUM_BINS, SPECTRUM_ROWS>;
+
+/*
+ * SpectrumAnalyzer
+ *    Worker thread that turns a SpectrumTap into a history of spectra. Every
+ *    hop samples it snapshots the newest fftSize samples, applies a Hann
+ *    window, runs a RealFft and folds the bins into SPECTRUM_BINS log-spaced
+ *    bands (peak per band). The audio callback only ever writes the tap, so
+ *    the worker can fall behind or be descheduled without affecting it; a
+ *    late worker skips to the newest samples instead of catching up.
+ *    A window of pure silence is pushed as a floor spectrum without an FFT.
+ *
+ *    Nothing here depends on Android.
+ */
+class SpectrumAnalyzer {
+public:
+    ~SpectrumAnalyzer() { stop(); }
+
+    // Any thread; fftSize is rounded down to a power of two and clamped to
+    // [SPECTRUM_MIN_FFT_SIZE, SPECTRUM_MAX_FFT_SIZE], hop to [1, fftSize].
+    // Takes effect before the next analysed frame.
+    void configure(int fftSize, int hop);
+
+    void start(const SpectrumTap &tap, float sampleRate);
+
+    void stop();
+
+    const SpectrumHistory &history() const { return spectra; }
+
+    uint64_t framesAnalyzed() const { return spectra.count(); }
+
+    // History count just after the newest frame with any band above the
+    // floor; frames after it are all floor.
+    uint64_t audibleEnd() const { return audibleFrames.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void rebuild(int size);
+    void analyze(uint64_t &analyzed);
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<int> requestedFftSize{2048};
+    std::atomic<int> requestedHop{512};
+
+    // Worker thread only.
+    const SpectrumTap *source = nullptr;
+    float rate = 48000.0f;
+    int fftSize = 0;
+    int hop = 0;
+    std::unique_ptr<RealFft> fft;
+    std::vector<float> window;
+    std::vector<float> samples;
+    std::vector<float> re, im;
+    std::vector<int> bandStart; // first FFT bin of each band, plus one past the last
+
+    SpectrumHistory spectra;
+    std::atomic<uint64_t> audibleFrames{0};
+};
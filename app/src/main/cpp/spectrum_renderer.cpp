@@ -0,0 +1,147 @@
+#include "spectrum_renderer.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "gl_program.h"
+
+SpectrumRenderer::SpectrumRenderer() {
+    for (int b = 0; b < SPECTRUM_BINS; b++) {
+        bands[b] = GLfloat(b);
+    }
+}
+
+void SpectrumRenderer::surfaceCreated(const SpectrumShaders &shaders) {
+    lineProgram = createProgram(shaders.lineVertex, shaders.lineFragment);
+    assert(lineProgram != 0);
+    GLint getBandLocationResult = glGetAttribLocation(lineProgram, "vBand");
+    assert(getBandLocationResult != -1);
+    vBandHandle = (GLuint) getBandLocationResult;
+    GLint getLevelLocationResult = glGetAttribLocation(lineProgram, "vLevel");
+    assert(getLevelLocationResult != -1);
+    vLevelHandle = (GLuint) getLevelLocationResult;
+    uBandScaleHandle = glGetUniformLocation(lineProgram, "uBandScale");
+    assert(uBandScaleHandle != -1);
+    uColorHandle = glGetUniformLocation(lineProgram, "uColor");
+    assert(uColorHandle != -1);
+
+    glUseProgram(lineProgram);
+    glUniform1f(uBandScaleHandle, 2.0f / GLfloat(SPECTRUM_BINS - 1));
+    glUniform4f(uColorHandle, 0.3f, 0.3f, 0.8f, 1.0f); // dim blue
+
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    bandBuffer = buffers[0];
+    levelBuffer = buffers[1];
+    glBindBuffer(GL_ARRAY_BUFFER, bandBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(bands), bands, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, levelBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(levels), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // GL objects die with the context, so start from a full upload.
+    lineUploaded = UINT64_MAX;
+    textureUploaded = UINT64_MAX;
+
+    const char *version = (const char *) glGetString(GL_VERSION);
+    hasSpectrogram = version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0;
+    if (!hasSpectrogram) return;
+
+    spectrogramProgram = createProgram(shaders.spectrogramVertex, shaders.spectrogramFragment);
+    assert(spectrogramProgram != 0);
+    GLint uSpectraHandle = glGetUniformLocation(spectrogramProgram, "uSpectra");
+    assert(uSpectraHandle != -1);
+    GLint uRowsHandle = glGetUniformLocation(spectrogramProgram, "uRows");
+    assert(uRowsHandle != -1);
+    GLint uBandsHandle = glGetUniformLocation(spectrogramProgram, "uBands");
+    assert(uBandsHandle != -1);
+    uHeadHandle = glGetUniformLocation(spectrogramProgram, "uHead");
+    assert(uHeadHandle != -1);
+
+    glUseProgram(spectrogramProgram);
+    glUniform1i(uSpectraHandle, 1);
+    glUniform1i(uRowsHandle, SPECTRUM_ROWS);
+    glUniform1i(uBandsHandle, SPECTRUM_BINS);
+
+    // Unit 1, so it never disturbs the trace history texture on unit 0.
+    glGenTextures(1, &spectraTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, spectraTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, SPECTRUM_ROWS, SPECTRUM_BINS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+int SpectrumRenderer::framesShown() const {
+    if (requestedView == SPECTRUM_VIEW_OFF) return 0;
+    return requestedView == SPECTRUM_VIEW_SPECTROGRAM && hasSpectrogram ? SPECTRUM_ROWS : 1;
+}
+
+void SpectrumRenderer::render(const SpectrumHistory &history) {
+    const uint64_t count = history.count();
+    if (requestedView == SPECTRUM_VIEW_OFF || count == 0) {
+        drawn = count;
+        return;
+    }
+    if (requestedView == SPECTRUM_VIEW_SPECTROGRAM && hasSpectrogram) {
+        renderSpectrogram(history, count);
+    } else {
+        renderLine(history, count);
+    }
+    drawn = count;
+}
+
+void SpectrumRenderer::renderLine(const SpectrumHistory &history, uint64_t count) {
+    glUseProgram(lineProgram);
+    glBindBuffer(GL_ARRAY_BUFFER, levelBuffer);
+    if (count != lineUploaded) {
+        // The analyzer keeps pushing while this runs; the snapshot is the
+        // newest whole frame, which may already be newer than count.
+        lineUploaded = history.snapshotLatest(levels);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(levels), levels);
+    }
+    glEnableVertexAttribArray(vLevelHandle);
+    glVertexAttribPointer(vLevelHandle, 1, GL_FLOAT, GL_FALSE, 0, (const void *) 0);
+    glBindBuffer(GL_ARRAY_BUFFER, bandBuffer);
+    glEnableVertexAttribArray(vBandHandle);
+    glVertexAttribPointer(vBandHandle, 1, GL_FLOAT, GL_FALSE, 0, (const void *) 0);
+
+    glDrawArrays(GL_LINE_STRIP, 0, SPECTRUM_BINS);
+
+    glDisableVertexAttribArray(vBandHandle);
+    glDisableVertexAttribArray(vLevelHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Same incremental column upload as TraceRenderer::syncTexture: frames
+// written since the last upload, at most two calls. The analyzer keeps
+// pushing while this runs, so the columns are first copied out under the
+// history's sequence count; the copy may end past count.
+void SpectrumRenderer::renderSpectrogram(const SpectrumHistory &history, uint64_t count) {
+    const GLsizei n = SPECTRUM_ROWS;
+    glUseProgram(spectrogramProgram);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, spectraTexture);
+    if (count != textureUploaded) {
+        const bool full = textureUploaded > count || count - textureUploaded >= uint64_t(n);
+        const uint64_t since = full ? 0 : textureUploaded;
+        const uint64_t end = history.snapshotSince(since, staging, SPECTRUM_ROWS);
+        const uint64_t first = end - since > uint64_t(n) ? end - n : since;
+        GLsizei from = GLsizei(first) & (n - 1);
+        GLsizei length = GLsizei(end - first);
+        GLsizei head = length < n - from ? length : n - from;
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, SPECTRUM_ROWS);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, from, 0, head, SPECTRUM_BINS, GL_RED, GL_FLOAT,
+                        staging);
+        if (length > head) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, length - head, SPECTRUM_BINS, GL_RED,
+                            GL_FLOAT, staging + head);
+        }
+        textureUploaded = end;
+    }
+    glUniform1i(uHeadHandle, GLint(textureUploaded & SpectrumHistory::kMask));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+#include <string_view>
+
+#include "spectrum_analyzer.h"
+
+const int SPECTRUM_VIEW_OFF = 0;
+const int SPECTRUM_VIEW_LINE = 1;
+const int SPECTRUM_VIEW_SPECTROGRAM = 2; // ES 3.0 only; falls back to the line
+
+// Shader sources; only needs to stay valid during surfaceCreated().
+struct SpectrumShaders {
+    std::string_view lineVertex;          // spectrum.glslv (ES 2.0)
+    std::string_view lineFragment;        // scope.glslf
+    std::string_view spectrogramVertex;   // spectrogram_es3.glslv (ES 3.0)
+    std::string_view spectrogramFragment; // spectrogram_es3.glslf
+};
+
+/*
+ * SpectrumRenderer
+ *    Draws a SpectrumHistory behind the traces, either as a line through the
+ *    newest spectrum or as a full-screen scrolling spectrogram. The
+ *    spectrogram streams new frames into a R32F texture laid out like the
+ *    history itself (one row per band), so each analysed frame costs one
+ *    column upload.
+ */
+class SpectrumRenderer {
+public:
+    SpectrumRenderer();
+
+    // (Re)creates all GL objects; call whenever a new context is current.
+    void surfaceCreated(const SpectrumShaders &shaders);
+
+    void setView(int view) { requestedView = view; }
+
+    void render(const SpectrumHistory &history);
+
+    // History write count of the last drawn frame.
+    uint64_t drawnCount() const { return drawn; }
+
+    // Newest frames the current view shows: all SPECTRUM_ROWS for the
+    // spectrogram, one for the line.
+    int framesShown() const;
+
+private:
+    void renderLine(const SpectrumHistory &history, uint64_t count);
+    void renderSpectrogram(const SpectrumHistory &history, uint64_t count);
+
+    int requestedView = SPECTRUM_VIEW_LINE;
+    bool hasSpectrogram = false;
+
+    GLuint lineProgram = 0;
+    GLuint vBandHandle = 0;
+    GLuint vLevelHandle = 0;
+    GLint uBandScaleHandle = -1;
+    GLint uColorHandle = -1;
+    GLuint bandBuffer = 0;
+    GLuint levelBuffer = 0;
+    GLfloat bands[SPECTRUM_BINS];
+    GLfloat levels[SPECTRUM_BINS];
+
+    GLuint spectrogramProgram = 0;
+    GLint uHeadHandle = -1;
+    GLuint spectraTexture = 0;
+    // Columns copied out of the history for one upload, one row per band.
+    GLfloat staging[SPECTRUM_BINS * SPECTRUM_ROWS];
+
+    // History write counts already in levelBuffer / spectraTexture.
+    uint64_t lineUploaded = 0;
+    uint64_t textureUploaded = 0;
+    uint64_t drawn = 0;
+};
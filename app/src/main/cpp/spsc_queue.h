@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * SpscQueue<T, N>
+ *    Bounded single-producer / single-consumer queue for handing events
+ *    from the sensor (GL) thread to the audio callback. push() and pop()
+ *    are wait-free: a full queue drops the new event rather than blocking
+ *    the producer, and the consumer never waits for one. T must be
+ *    trivially copyable; N a power of two.
+ */
+template<typename T, std::size_t N>
+class SpscQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue length must be a power of two");
+
+public:
+    // Producer thread only; false when the queue is full.
+    bool push(const T &value) {
+        uint64_t tail = written.load(std::memory_order_relaxed);
+        if (tail - read.load(std::memory_order_acquire) >= N) return false;
+        slots[std::size_t(tail) & (N - 1)] = value;
+        written.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only; false when the queue is empty.
+    bool pop(T &value) {
+        uint64_t head = read.load(std::memory_order_relaxed);
+        if (head == written.load(std::memory_order_acquire)) return false;
+        value = slots[std::size_t(head) & (N - 1)];
+        read.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T slots[N];
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> read{0};
+};
@@ -0,0 +1,97 @@
+#include "svf_filter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+const float MIN_CUTOFF_HZ = 20.0f;
+const float MAX_CUTOFF_RATIO = 0.49f; // of the sample rate; tan() blows up at 0.5
+const float MIN_DAMPING = 0.04f;      // at resonance 1
+const float DENORMAL_LEVEL = 1e-15f;
+
+} // namespace
+
+void SvfFilter::setSampleRate(float sampleRate) {
+    rate = sampleRate;
+    smoothing = 1.0f - std::exp(-1.0f / (SVF_SMOOTHING_SECONDS * rate));
+    settled = false;
+    for (int c = 0; c < 2; c++) {
+        ic1[c] = 0.0f;
+        ic2[c] = 0.0f;
+    }
+}
+
+void SvfFilter::setMode(int value) {
+    mode = value;
+}
+
+void SvfFilter::setTarget(float cutoffHz, float resonance) {
+    float cutoff = std::clamp(cutoffHz, MIN_CUTOFF_HZ, MAX_CUTOFF_RATIO * rate);
+    gTarget = std::tan(3.14159265f * cutoff / rate);
+    kTarget = 2.0f - (2.0f - MIN_DAMPING) * std::clamp(resonance, 0.0f, 1.0f);
+    if (!settled) {
+        g = gTarget;
+        k = kTarget;
+        settled = true;
+    }
+}
+
+template<int Mode>
+void SvfFilter::run(float *block, int frameCount) {
+    float gNow = g;
+    float kNow = k;
+    float s1L = ic1[0], s2L = ic2[0];
+    float s1R = ic1[1], s2R = ic2[1];
+    for (int f = 0; f < frameCount; f++) {
+        gNow += smoothing * (gTarget - gNow);
+        kNow += smoothing * (kTarget - kNow);
+        const float a1 = 1.0f / (1.0f + gNow * (gNow + kNow));
+        const float a2 = gNow * a1;
+        const float a3 = gNow * a2;
+
+        float inL = block[2 * f];
+        float v3L = inL - s2L;
+        float v1L = a1 * s1L + a2 * v3L;
+        float v2L = s2L + a2 * s1L + a3 * v3L;
+        s1L = 2.0f * v1L - s1L;
+        s2L = 2.0f * v2L - s2L;
+
+        float inR = block[2 * f + 1];
+        float v3R = inR - s2R;
+        float v1R = a1 * s1R + a2 * v3R;
+        float v2R = s2R + a2 * s1R + a3 * v3R;
+        s1R = 2.0f * v1R - s1R;
+        s2R = 2.0f * v2R - s2R;
+
+        if (Mode == SVF_LOWPASS) {
+            block[2 * f] = v2L;
+            block[2 * f + 1] = v2R;
+        } else if (Mode == SVF_BANDPASS) {
+            block[2 * f] = v1L;
+            block[2 * f + 1] = v1R;
+        } else {
+            block[2 * f] = inL - kNow * v1L - v2L;
+            block[2 * f + 1] = inR - kNow * v1R - v2R;
+        }
+    }
+    g = gNow;
+    k = kNow;
+    // Flush decayed state so silence going in doesn't turn into denormals.
+    ic1[0] = std::fabs(s1L) < DENORMAL_LEVEL ? 0.0f : s1L;
+    ic2[0] = std::fabs(s2L) < DENORMAL_LEVEL ? 0.0f : s2L;
+    ic1[1] = std::fabs(s1R) < DENORMAL_LEVEL ? 0.0f : s1R;
+    ic2[1] = std::fabs(s2R) < DENORMAL_LEVEL ? 0.0f : s2R;
+}
+
+void SvfFilter::process(float *block, int frameCount) {
+    assert(frameCount <= DSP_BLOCK_FRAMES);
+    if (mode == SVF_BANDPASS) {
+        run<SVF_BANDPASS>(block, frameCount);
+    } else if (mode == SVF_HIGHPASS) {
+        run<SVF_HIGHPASS>(block, frameCount);
+    } else {
+        run<SVF_LOWPASS>(block, frameCount);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "block_adapter.h"
+
+const int SVF_LOWPASS = 0;
+const int SVF_BANDPASS = 1;
+const int SVF_HIGHPASS = 2;
+
+const float SVF_SMOOTHING_SECONDS = 0.005f; // coefficient glide time constant
+
+/*
+ * SvfFilter
+ *    Stereo state-variable filter in the topology-preserving (trapezoidal)
+ *    form, so it stays stable and keeps its tuning when the cutoff moves
+ *    every sample. setTarget() computes the prewarped gain g = tan(pi fc / fs)
+ *    once; process() then glides g and the damping toward their targets
+ *    sample by sample, so cutoff changes from the sensors are smooth at
+ *    audio rate without a tan() per sample.
+ *
+ *    setSampleRate() / setMode() while the device is stopped; setTarget()
+ *    and process() on the audio thread.
+ */
+class SvfFilter {
+public:
+    // Clears the filter state; the next setTarget() takes effect at once.
+    void setSampleRate(float sampleRate);
+
+    void setMode(int mode);
+
+    // resonance 0..1: Q from 0.5 (no peak) up to about 25 (near self-oscillation).
+    void setTarget(float cutoffHz, float resonance);
+
+    // Filters frameCount (<= DSP_BLOCK_FRAMES) interleaved stereo frames in place.
+    void process(float *block, int frameCount);
+
+private:
+    template<int Mode>
+    void run(float *block, int frameCount);
+
+    float rate = 48000.0f;
+    float smoothing = 1.0f; // per-sample glide factor
+    int mode = SVF_LOWPASS;
+    bool settled = false;
+
+    float g = 0.0f;
+    float gTarget = 0.0f;
+    float k = 2.0f; // damping, 1 / Q
+    float kTarget = 2.0f;
+
+    // Integrator states, per channel.
+    float ic1[2] = {0.0f, 0.0f};
+    float ic2[2] = {0.0f, 0.0f};
+};
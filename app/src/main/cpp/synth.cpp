@@ -0,0 +1,185 @@
+#include "synth.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const float LEAD_GLIDE_SECONDS = 0.02f;
+const int PREWARM_BLOCKS = 4;
+const float CHORD_HOLD_SECONDS = 0.15f;
+const float CHORD_RELEASE_SECONDS = 0.4f;
+const float CHORD_BRIGHTNESS = 0.5f;
+const float CHORD_SPREAD = 0.6f; // pan range across the notes of a chord
+
+const int CHORD_MAX_NOTES = 3;
+// Semitones above the root; unused slots are -1.
+const int CHORD_INTERVALS[CHORD_COUNT][CHORD_MAX_NOTES] = {
+        {0, -1, -1},
+        {0, 4, 7},
+        {0, 3, 7},
+        {0, 5, 7},
+        {0, 12, 19},
+};
+
+} // namespace
+
+void Synth::prepare(float sampleRate) {
+    rate = sampleRate;
+    glide = 1.0f - std::exp(-float(DSP_BLOCK_FRAMES) / (LEAD_GLIDE_SECONDS * rate));
+    voices.setSampleRate(rate);
+    lead.setSampleRate(rate);
+    filter.setSampleRate(rate);
+    envelope.setSampleRate(rate);
+    gated = false;
+    leadFrequency = leadFrequencyTarget.load();
+    leadGain = leadGainTarget.load();
+    leadLevel = 0.0f;
+    leadDetune = leadDetuneTarget.load();
+    leadSpread = leadSpreadTarget.load();
+    master = 0.0f;
+    masterStep = std::min(float(DSP_BLOCK_FRAMES) / (SYNTH_FADE_SECONDS * rate), 1.0f);
+    silenced.store(muted.load());
+    voicesActive = 0;
+}
+
+void Synth::configureLead(int wave, int unisonVoices) {
+    lead.setWave(wave);
+    lead.setVoices(unisonVoices);
+}
+
+void Synth::configureFilter(int mode) {
+    filter.setMode(mode);
+}
+
+void Synth::configureEnvelope(const AdsrParams &params) {
+    envelope.setParams(params);
+}
+
+void Synth::setLead(float frequency, float gain) {
+    leadFrequencyTarget.store(frequency, std::memory_order_relaxed);
+    leadGainTarget.store(gain, std::memory_order_relaxed);
+}
+
+void Synth::setUnison(float detune, float spread) {
+    leadDetuneTarget.store(detune, std::memory_order_relaxed);
+    leadSpreadTarget.store(spread, std::memory_order_relaxed);
+}
+
+void Synth::setFilter(float cutoffHz, float resonance) {
+    filterCutoff.store(cutoffHz, std::memory_order_relaxed);
+    filterResonance.store(resonance, std::memory_order_relaxed);
+}
+
+void Synth::setGate(bool on) {
+    gateTarget.store(on, std::memory_order_relaxed);
+}
+
+void Synth::setMuted(bool on) {
+    if (!on) silenced.store(false, std::memory_order_release);
+    muted.store(on, std::memory_order_relaxed);
+}
+
+void Synth::prewarm() {
+    // Copying reads the live state into cache and running the copies warms
+    // the code, without advancing any phase, voice or filter state the
+    // next callback carries on from.
+    UnisonOscillator scratchLead = lead;
+    VoicePool scratchVoices = voices;
+    SvfFilter scratchFilter = filter;
+    for (int b = 0; b < PREWARM_BLOCKS; b++) {
+        std::memset(prewarmBlock, 0, sizeof(prewarmBlock));
+        scratchLead.set(leadFrequency, leadDetune, leadSpread);
+        scratchLead.render(prewarmBlock, DSP_BLOCK_FRAMES, 0.0f, 0.0f);
+        scratchVoices.render(prewarmBlock, DSP_BLOCK_FRAMES);
+        scratchFilter.process(prewarmBlock, DSP_BLOCK_FRAMES);
+    }
+}
+
+void Synth::renderSilence(float *block, float masterTarget) {
+    std::memset(block, 0, sizeof(float) * 2 * DSP_BLOCK_FRAMES);
+    // Nothing to glide from: the next note starts right on its targets.
+    leadFrequency = leadFrequencyTarget.load(std::memory_order_relaxed);
+    leadGain = leadGainTarget.load(std::memory_order_relaxed);
+    leadDetune = leadDetuneTarget.load(std::memory_order_relaxed);
+    leadSpread = leadSpreadTarget.load(std::memory_order_relaxed);
+    leadLevel = 0.0f;
+    // Nothing audible to fade either.
+    master = masterTarget;
+    if (masterTarget == 0.0f) silenced.store(true, std::memory_order_release);
+    voicesActive.store(voices.activeVoices(), std::memory_order_relaxed);
+    silentBlockCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool Synth::trigger(float rootFrequency, int chord, float gain) {
+    return triggers.push({rootFrequency, gain, std::clamp(chord, 0, CHORD_COUNT - 1)});
+}
+
+void Synth::play(const Trigger &trigger) {
+    const int *intervals = CHORD_INTERVALS[trigger.chord];
+    int notes = 0;
+    while (notes < CHORD_MAX_NOTES && intervals[notes] >= 0) notes++;
+    for (int n = 0; n < notes; n++) {
+        VoiceParams note;
+        note.frequency = trigger.rootFrequency * std::exp2(float(intervals[n]) / 12.0f);
+        note.gain = trigger.gain;
+        note.pan = notes > 1 ? CHORD_SPREAD * (2.0f * float(n) / float(notes - 1) - 1.0f) : 0.0f;
+        note.brightness = CHORD_BRIGHTNESS;
+        note.releaseSeconds = CHORD_RELEASE_SECONDS;
+        note.holdSeconds = CHORD_HOLD_SECONDS;
+        voices.noteOn(note);
+    }
+}
+
+void Synth::render(float *block) {
+    Trigger pending;
+    while (triggers.pop(pending)) play(pending);
+
+    const bool gate = gateTarget.load(std::memory_order_relaxed);
+    if (gate != gated) {
+        envelope.gate(gate);
+        gated = gate;
+    }
+    const float masterTarget = muted.load(std::memory_order_relaxed) ? 0.0f : 1.0f;
+    if ((envelope.idle() && voices.activeVoices() == 0) ||
+        (master == 0.0f && masterTarget == 0.0f)) {
+        renderSilence(block, masterTarget);
+        return;
+    }
+
+    const float levelFrom = leadLevel;
+    leadFrequency += glide * (leadFrequencyTarget.load(std::memory_order_relaxed) - leadFrequency);
+    leadGain += glide * (leadGainTarget.load(std::memory_order_relaxed) - leadGain);
+    leadDetune += glide * (leadDetuneTarget.load(std::memory_order_relaxed) - leadDetune);
+    leadSpread += glide * (leadSpreadTarget.load(std::memory_order_relaxed) - leadSpread);
+    leadLevel = leadGain * envelope.advance(DSP_BLOCK_FRAMES);
+    filter.setTarget(filterCutoff.load(std::memory_order_relaxed),
+                     filterResonance.load(std::memory_order_relaxed));
+
+    std::memset(block, 0, sizeof(float) * 2 * DSP_BLOCK_FRAMES);
+    if (levelFrom > 0.0f || leadLevel > 0.0f) {
+        lead.set(leadFrequency, leadDetune, leadSpread);
+        lead.render(block, DSP_BLOCK_FRAMES, levelFrom, leadLevel);
+    }
+    voices.render(block, DSP_BLOCK_FRAMES);
+    filter.process(block, DSP_BLOCK_FRAMES);
+
+    // Within a step (plus rounding) of the target lands on it, so a fade
+    // takes exactly fadeBlocks() blocks.
+    const float masterFrom = master;
+    const float remaining = masterTarget - master;
+    master = std::fabs(remaining) <= 1.001f * masterStep ? masterTarget
+                                                         : master + std::copysign(masterStep, remaining);
+    if (masterFrom != 1.0f || master != 1.0f) {
+        const float step = (master - masterFrom) / float(DSP_BLOCK_FRAMES);
+        for (int f = 0; f < DSP_BLOCK_FRAMES; f++) {
+            const float gain = masterFrom + step * float(f + 1);
+            block[2 * f] *= gain;
+            block[2 * f + 1] *= gain;
+        }
+    }
+    if (master == 0.0f && masterTarget == 0.0f) silenced.store(true, std::memory_order_release);
+    voicesActive.store(voices.activeVoices(), std::memory_order_relaxed);
+    voicesStolenCount.store(voices.voicesStolen(), std::memory_order_relaxed);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "adsr_envelope.h"
+#include "spsc_queue.h"
+#include "svf_filter.h"
+#include "unison_oscillator.h"
+#include "voice_pool.h"
+
+const float SYNTH_FADE_SECONDS = 0.02f; // output fade on mute / unmute and after prepare()
+
+// Chords a gesture can trigger, stacked on the current lead pitch.
+const int CHORD_SINGLE = 0;
+const int CHORD_MAJOR = 1;
+const int CHORD_MINOR = 2;
+const int CHORD_SUS4 = 3;
+const int CHORD_OCTAVES = 4;
+const int CHORD_COUNT = 5;
+
+/*
+ * Synth
+ *    The instrument rendered by the audio callback: a UnisonOscillator lead
+ *    whose pitch, level, detune and stereo spread follow the sensors and
+ *    which is articulated by an AdsrEnvelope on setGate(), plus a VoicePool
+ *    for short notes and chords triggered by gestures, all through one
+ *    SvfFilter. The sensor thread talks to it only through setLead() /
+ *    setUnison() / setFilter() / setGate() (atomics, picked up once per
+ *    block) and trigger() (an SpscQueue drained at the start of each
+ *    block), so the callback never waits on it.
+ *
+ *    While the envelope is idle and no pool voice is playing, or the output
+ *    is muted and faded out, render() only zeroes the block: no oscillator
+ *    or filter work at all. The whole output fades in over
+ *    SYNTH_FADE_SECONDS after prepare() and on setMuted(false), and out on
+ *    setMuted(true), so the device can be stopped and started without
+ *    clicks.
+ */
+class Synth {
+public:
+    // Control thread, while the device is stopped: rebuilds rate-dependent
+    // state and silences every voice.
+    void prepare(float sampleRate);
+
+    // Control thread, while the device is stopped.
+    void configureLead(int wave, int unisonVoices);
+
+    // Control thread, while the device is stopped: SVF_LOWPASS etc.
+    void configureFilter(int mode);
+
+    // Control thread, while the device is stopped.
+    void configureEnvelope(const AdsrParams &params);
+
+    // Sensor thread.
+    void setLead(float frequency, float gain);
+
+    // Sensor thread: detune and spread 0..1, see UnisonOscillator::set().
+    void setUnison(float detune, float spread);
+
+    // Sensor thread: see SvfFilter::setTarget().
+    void setFilter(float cutoffHz, float resonance);
+
+    // Sensor thread: opens / closes the lead's envelope.
+    void setGate(bool on);
+
+    // Control thread: fades the whole output out / back in.
+    void setMuted(bool muted);
+
+    // True once a setMuted(true) fade has reached silence.
+    bool fadedOut() const { return silenced.load(std::memory_order_acquire); }
+
+    // Blocks a setMuted() fade takes at the prepared rate.
+    int fadeBlocks() const { return int(std::ceil(1.0f / masterStep)); }
+
+    // Control thread, while the device is stopped: runs copies of the
+    // oscillator, voices and filter over a few discarded blocks, so the
+    // first callback after a start doesn't also pay for cold caches. The
+    // live state is only read, so the output is the same as without it.
+    void prewarm();
+
+    // Sensor thread: plays chord on rootFrequency; false if the queue is full.
+    bool trigger(float rootFrequency, int chord, float gain);
+
+    // Audio thread: renders one DSP_BLOCK_FRAMES interleaved stereo block.
+    void render(float *block);
+
+    int activeVoices() const { return voicesActive.load(std::memory_order_relaxed); }
+
+    uint64_t voicesStolen() const { return voicesStolenCount.load(std::memory_order_relaxed); }
+
+    // Blocks rendered as plain silence so far.
+    uint64_t silentBlocks() const { return silentBlockCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Trigger {
+        float rootFrequency;
+        float gain;
+        int chord;
+    };
+
+    void play(const Trigger &trigger);
+    void renderSilence(float *block, float masterTarget);
+
+    UnisonOscillator lead;
+    AdsrEnvelope envelope;
+    VoicePool voices;
+    SvfFilter filter;
+    SpscQueue<Trigger, 64> triggers;
+    float rate = 48000.0f;
+    float glide = 1.0f; // per-block smoothing factor for the lead
+
+    std::atomic<float> leadFrequencyTarget{220.0f};
+    std::atomic<float> leadGainTarget{0.2f};
+    std::atomic<float> leadDetuneTarget{0.0f};
+    std::atomic<float> leadSpreadTarget{0.0f};
+    std::atomic<float> filterCutoff{20000.0f};
+    std::atomic<float> filterResonance{0.0f};
+    std::atomic<bool> gateTarget{false};
+    bool gated = false;
+    std::atomic<bool> muted{false};
+    std::atomic<bool> silenced{false};
+    float master = 0.0f;     // output gain, faded toward 0 or 1
+    float masterStep = 1.0f; // per block
+    float leadFrequency = 220.0f;
+    float leadGain = 0.0f;
+    float leadDetune = 0.0f;
+    float leadSpread = 0.0f;
+    float leadLevel = 0.0f; // leadGain times the envelope, at the end of the last block
+
+    std::atomic<int> voicesActive{0};
+    std::atomic<uint64_t> voicesStolenCount{0};
+    std::atomic<uint64_t> silentBlockCount{0};
+
+    alignas(DSP_BLOCK_ALIGNMENT) float prewarmBlock[2 * DSP_BLOCK_FRAMES];
+};
@@ -0,0 +1,76 @@
+// AdsrEnvelope stage transitions a block at a time: an audible sustain
+// holds until the gate closes and then releases to idle; a sustain at or
+// below ENVELOPE_SILENT_LEVEL goes idle at the end of the decay with the
+// gate still open, and stays there until the next gate(true).
+#include <initializer_list>
+
+#include "adsr_envelope.h"
+#include "block_adapter.h"
+#include "test_check.h"
+
+namespace {
+
+const float RATE = 48000.0f;
+const int MAX_BLOCKS = 48000; // 64 s; every stage here ends well before
+
+// Advances until the stage changes from stage; returns the blocks taken,
+// or MAX_BLOCKS if it never does.
+int blocksIn(AdsrEnvelope &envelope, int stage) {
+    for (int b = 0; b < MAX_BLOCKS; b++) {
+        envelope.advance(DSP_BLOCK_FRAMES);
+        if (envelope.stage() != stage) return b + 1;
+    }
+    return MAX_BLOCKS;
+}
+
+AdsrEnvelope envelopeWith(float sustainLevel) {
+    AdsrEnvelope envelope;
+    envelope.setSampleRate(RATE);
+    envelope.setParams(AdsrParams{0.01f, 0.15f, sustainLevel, 0.4f});
+    return envelope;
+}
+
+} // namespace
+
+int main() {
+    // Audible sustain: attack, decay, hold, release.
+    AdsrEnvelope held = envelopeWith(0.7f);
+    CHECK(held.idle());
+    held.gate(true);
+    CHECK(blocksIn(held, ENVELOPE_ATTACK) < MAX_BLOCKS);
+    CHECK(held.stage() == ENVELOPE_DECAY);
+    CHECK(blocksIn(held, ENVELOPE_DECAY) < MAX_BLOCKS);
+    CHECK(held.stage() == ENVELOPE_SUSTAIN);
+    CHECK(held.level() == 0.7f);
+    CHECK(blocksIn(held, ENVELOPE_SUSTAIN) == MAX_BLOCKS);
+    held.gate(false);
+    CHECK(blocksIn(held, ENVELOPE_RELEASE) < MAX_BLOCKS);
+    CHECK(held.idle());
+    CHECK(held.level() == 0.0f);
+
+    // Silent sustains, at zero and at the threshold: percussive, idle with
+    // the gate still open.
+    for (float sustain : {0.0f, ENVELOPE_SILENT_LEVEL}) {
+        AdsrEnvelope percussive = envelopeWith(sustain);
+        percussive.gate(true);
+        blocksIn(percussive, ENVELOPE_ATTACK);
+        CHECK(percussive.stage() == ENVELOPE_DECAY);
+        CHECK(blocksIn(percussive, ENVELOPE_DECAY) < MAX_BLOCKS);
+        CHECK(percussive.idle());
+        CHECK(percussive.level() == 0.0f);
+        CHECK(blocksIn(percussive, ENVELOPE_IDLE) == MAX_BLOCKS);
+        // Closing the gate changes nothing; opening it plays again.
+        percussive.gate(false);
+        CHECK(percussive.idle());
+        percussive.gate(true);
+        CHECK(percussive.stage() == ENVELOPE_ATTACK);
+    }
+
+    // Just above the threshold is still a sustain.
+    AdsrEnvelope quiet = envelopeWith(2.0f * ENVELOPE_SILENT_LEVEL);
+    quiet.gate(true);
+    blocksIn(quiet, ENVELOPE_ATTACK);
+    blocksIn(quiet, ENVELOPE_DECAY);
+    CHECK(quiet.stage() == ENVELOPE_SUSTAIN);
+    return testFailures();
+}
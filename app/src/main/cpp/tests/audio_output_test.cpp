@@ -0,0 +1,186 @@
+// Configuration and restart path of AudioOutput on miniaudio's null backend:
+// every latency profile opens with the period the profile asks for, the
+// device stops and restarts cleanly, and info() stays consistent for a
+// reader on another thread while profiles are switched. A synth muted as
+// pause() mutes it has faded out by the end of pause()'s bounded wait, and
+// plays again after prewarm(), unmute and restart.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "audio_output.h"
+#include "output_stage.h"
+#include "synth.h"
+#include "test_check.h"
+
+namespace {
+
+const int NATIVE_RATE = 48000;
+const int NATIVE_BURST = 192;
+// Period frames each profile should ask for, in bursts; see LATENCY_PROFILES.
+const uint32_t PROFILE_BURSTS[LATENCY_PROFILE_COUNT] = {1, 2, 8};
+const int RESTART_GAP_MS = 200;
+
+struct Counter {
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> misaligned{0};
+};
+
+void renderBlock(void *user, float *block) {
+    Counter *counter = (Counter *) user;
+    if (uintptr_t(block) % DSP_BLOCK_ALIGNMENT != 0) counter->misaligned++;
+    for (int i = 0; i < DSP_BLOCK_FRAMES * AUDIO_OUTPUT_CHANNELS; i++) block[i] = 0.0f;
+    counter->blocks++;
+}
+
+// Waits up to a second for the device to render more blocks.
+bool rendersMore(const Counter &counter) {
+    const uint64_t from = counter.blocks.load();
+    for (int i = 0; i < 100; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (counter.blocks.load() > from + 4) return true;
+    }
+    return false;
+}
+
+void checkProfiles(AudioOutput &output, Counter &counter) {
+    for (int profile = 0; profile < LATENCY_PROFILE_COUNT; profile++) {
+        CHECK(output.configure(profile));
+        const AudioOutput::Info info = output.info();
+        CHECK(info.profile == profile);
+        CHECK(info.sampleRate == uint32_t(NATIVE_RATE));
+        CHECK(info.periodFrames == PROFILE_BURSTS[profile] * NATIVE_BURST);
+        CHECK(info.periods > 0);
+        CHECK(info.conversion == 0);
+
+        CHECK(output.start());
+        CHECK(rendersMore(counter));
+        output.stop();
+        const uint64_t stopped = counter.blocks.load();
+        const uint64_t missedBefore = output.stats().missed;
+        std::this_thread::sleep_for(std::chrono::milliseconds(RESTART_GAP_MS));
+        CHECK(counter.blocks.load() == stopped);
+
+        // The same device restarts without another configure(), and the
+        // gap isn't counted as missed callbacks (the null backend's timer
+        // jitter may still make a few late).
+        CHECK(output.start());
+        CHECK(rendersMore(counter));
+        output.stop();
+        const double periodMs = 1000.0 * info.periodFrames / info.sampleRate;
+        CHECK(double(output.stats().missed - missedBefore) < 0.5 * RESTART_GAP_MS / periodMs);
+    }
+}
+
+// A reader polling info() while the control thread switches profiles must
+// never see one profile's period with another's number.
+void checkConcurrentInfo(AudioOutput &output) {
+    std::atomic<bool> reading{true};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> torn{0};
+    std::thread reader([&] {
+        while (reading.load()) {
+            const AudioOutput::Info info = output.info();
+            if (info.periodFrames != PROFILE_BURSTS[info.profile] * NATIVE_BURST) torn++;
+            reads++;
+        }
+    });
+    for (int i = 0; i < 30; i++) CHECK(output.configure(i % LATENCY_PROFILE_COUNT));
+    reading = false;
+    reader.join();
+    CHECK(reads.load() > 0);
+    CHECK(torn.load() == 0);
+}
+
+// The synth and output stage as native-lib renders them.
+struct Player {
+    Synth synth;
+    OutputStage outputStage;
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> audibleBlocks{0};
+    std::atomic<float> lastPeak{0.0f};
+};
+
+void renderPlayer(void *user, float *block) {
+    Player *player = (Player *) user;
+    player->synth.render(block);
+    player->outputStage.process(block);
+    float peak = 0.0f;
+    for (int i = 0; i < DSP_BLOCK_FRAMES * AUDIO_OUTPUT_CHANNELS; i++) peak = std::max(peak, std::fabs(block[i]));
+    if (peak > 0.0f) player->audibleBlocks++;
+    player->lastPeak.store(peak);
+    player->blocks++;
+}
+
+// Waits up to a second for more audible blocks.
+bool playsMore(const Player &player) {
+    const uint64_t from = player.audibleBlocks.load();
+    for (int i = 0; i < 100; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (player.audibleBlocks.load() > from + 4) return true;
+    }
+    return false;
+}
+
+void checkMutedPause() {
+    std::unique_ptr<Player> player = std::make_unique<Player>();
+    AudioOutput output;
+    ma_backend nullBackend = ma_backend_null;
+    CHECK(output.open(renderPlayer, player.get(), &nullBackend, 1));
+    output.setNativeParams(NATIVE_RATE, NATIVE_BURST);
+    CHECK(output.configure(LATENCY_PROFILE_BALANCED));
+    const AudioOutput::Info info = output.info();
+    player->synth.setLead(220.0f, 0.2f);
+    player->synth.prepare(float(info.sampleRate));
+    player->outputStage.prepare(float(info.sampleRate));
+    player->synth.setGate(true);
+    CHECK(output.start());
+    CHECK(playsMore(*player));
+
+    // pause(): mute, one sleep of the fade plus a device period, stop.
+    player->synth.setMuted(true);
+    const double fadeSeconds = double(player->synth.fadeBlocks() * DSP_BLOCK_FRAMES + info.periodFrames) /
+                               double(info.sampleRate);
+    std::this_thread::sleep_for(std::chrono::duration<double>(fadeSeconds));
+    CHECK(player->synth.fadedOut());
+    output.stop();
+    // What's left is the output stage's held block and DC-blocker tail,
+    // well under -60 dB.
+    CHECK(player->lastPeak.load() < 1e-3f);
+    const uint64_t stopped = player->blocks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(RESTART_GAP_MS));
+    CHECK(player->blocks.load() == stopped);
+
+    // resume(): prewarm while stopped, unmute, restart.
+    player->synth.prewarm();
+    player->synth.setMuted(false);
+    CHECK(output.start());
+    CHECK(playsMore(*player));
+    output.stop();
+    output.close();
+}
+
+} // namespace
+
+int main() {
+    Counter counter;
+    AudioOutput output;
+    ma_backend nullBackend = ma_backend_null;
+    CHECK(!output.configure(LATENCY_PROFILE_BALANCED)); // no context yet
+    CHECK(output.open(renderBlock, &counter, &nullBackend, 1));
+    output.setNativeParams(NATIVE_RATE, NATIVE_BURST);
+
+    checkProfiles(output, counter);
+    checkConcurrentInfo(output);
+    CHECK(counter.misaligned.load() == 0);
+
+    output.close();
+    CHECK(!output.configured());
+
+    checkMutedPause();
+    return testFailures();
+}
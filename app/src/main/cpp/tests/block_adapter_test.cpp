@@ -0,0 +1,116 @@
+// BlockAdapter against randomized callback sizes and output buffers at
+// every float offset from an aligned address: the output must be the
+// rendered stream with no frame lost, repeated or reordered, every block
+// must be rendered aligned, and nothing outside the requested frames may
+// be written.
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "block_adapter.h"
+#include "test_check.h"
+
+namespace {
+
+const int CHANNELS = 2;
+const int MAX_CALLBACK_FRAMES = 3000;
+const int CALLBACKS = 20000;
+const float GUARD = -1.0f; // never rendered, see sampleValue()
+
+using Adapter = BlockAdapter<DSP_BLOCK_FRAMES, CHANNELS>;
+
+struct Source {
+    uint64_t nextFrame = 0;
+    uint64_t blocks = 0;
+    uint64_t misaligned = 0;
+};
+
+// Distinct for every sample in a 2^22-frame span and exact in float.
+float sampleValue(uint64_t frame, int channel) {
+    return float((frame * CHANNELS + channel) & 0x7fffff);
+}
+
+void renderBlock(void *user, float *block) {
+    Source *source = (Source *) user;
+    if (uintptr_t(block) % DSP_BLOCK_ALIGNMENT != 0) source->misaligned++;
+    for (int f = 0; f < DSP_BLOCK_FRAMES; f++) {
+        for (int c = 0; c < CHANNELS; c++) {
+            block[f * CHANNELS + c] = sampleValue(source->nextFrame + f, c);
+        }
+    }
+    source->nextFrame += DSP_BLOCK_FRAMES;
+    source->blocks++;
+}
+
+void checkRandomCallbacks() {
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> sizes(0, MAX_CALLBACK_FRAMES);
+    std::uniform_int_distribution<int> offsets(0, DSP_BLOCK_ALIGNMENT / sizeof(float) - 1);
+    std::uniform_int_distribution<int> blockMultiples(0, 3); // bias toward whole blocks
+
+    // One aligned arena; each callback writes at a random float offset in it.
+    const size_t arenaFloats = (MAX_CALLBACK_FRAMES + DSP_BLOCK_FRAMES) * CHANNELS + 64;
+    std::vector<float> storage(arenaFloats + DSP_BLOCK_ALIGNMENT / sizeof(float));
+    float *arena = storage.data();
+    while (uintptr_t(arena) % DSP_BLOCK_ALIGNMENT) arena++;
+
+    Adapter adapter;
+    Source source;
+    uint64_t expected = 0; // next frame the output should carry
+    uint64_t mismatches = 0;
+    uint64_t overruns = 0;
+    for (int i = 0; i < CALLBACKS; i++) {
+        int frames = sizes(random);
+        if (blockMultiples(random) == 0) frames -= frames % DSP_BLOCK_FRAMES;
+        const int offset = offsets(random);
+        std::fill(arena, arena + arenaFloats, GUARD);
+        float *out = arena + 8 + offset;
+        adapter.read(out, uint32_t(frames), renderBlock, &source);
+
+        for (int f = 0; f < frames; f++) {
+            for (int c = 0; c < CHANNELS; c++) {
+                if (out[f * CHANNELS + c] != sampleValue(expected + f, c)) mismatches++;
+            }
+        }
+        for (float *p = arena; p < out; p++) overruns += *p != GUARD;
+        for (float *p = out + frames * CHANNELS; p < arena + arenaFloats; p++) overruns += *p != GUARD;
+        expected += frames;
+        // Everything rendered is either handed out or pending.
+        CHECK(source.nextFrame == expected + adapter.pendingFrames());
+        CHECK(adapter.pendingFrames() < uint32_t(DSP_BLOCK_FRAMES));
+    }
+    CHECK(mismatches == 0);
+    CHECK(overruns == 0);
+    CHECK(source.misaligned == 0);
+    CHECK(source.blocks == (expected + DSP_BLOCK_FRAMES - 1) / DSP_BLOCK_FRAMES);
+}
+
+// Aligned whole-block callbacks render straight into the output; reset()
+// drops the partial block.
+void checkDirectAndReset() {
+    alignas(DSP_BLOCK_ALIGNMENT) float out[4 * DSP_BLOCK_FRAMES * CHANNELS];
+    Adapter adapter;
+    Source source;
+    adapter.read(out, 4 * DSP_BLOCK_FRAMES, renderBlock, &source);
+    CHECK(source.blocks == 4);
+    CHECK(adapter.pendingFrames() == 0);
+    CHECK(out[4 * DSP_BLOCK_FRAMES * CHANNELS - 1] == sampleValue(4 * DSP_BLOCK_FRAMES - 1, 1));
+
+    adapter.read(out, 10, renderBlock, &source);
+    CHECK(adapter.pendingFrames() == uint32_t(DSP_BLOCK_FRAMES - 10));
+    adapter.reset();
+    CHECK(adapter.pendingFrames() == 0);
+    adapter.read(out, 1, renderBlock, &source);
+    CHECK(out[0] == sampleValue(5 * DSP_BLOCK_FRAMES, 0)); // a fresh block
+    adapter.read(out, 0, renderBlock, &source);
+    CHECK(source.blocks == 6);
+}
+
+} // namespace
+
+int main() {
+    checkRandomCallbacks();
+    checkDirectAndReset();
+    return testFailures();
+}
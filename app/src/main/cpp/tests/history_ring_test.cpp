@@ -0,0 +1,224 @@
+// HistoryRing / SoAHistoryRing windows, and SoAHistoryRing::snapshotLatest(),
+// snapshotWindow() and snapshotSince() racing a writer: every snapshot must
+// hold whole pushed frames.
+// MinMaxPyramid windows at every level against brute-force min/max over the
+// raw stream.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "history_ring.h"
+#include "lod_history.h"
+#include "test_check.h"
+
+namespace {
+
+const int CHANNELS = 64;
+const int LENGTH = 8; // short, so the writer laps the ring constantly
+const int RACE_MILLISECONDS = 300; // long enough to interleave on one core
+// Multi-frame copies, long enough to be preempted on one core. Their
+// writer pushes in bursts, so that with more cores a copy that has to see no
+// overwrite still finishes between them.
+const int SINCE_CHANNELS = 128;
+const int SINCE_LENGTH = 512;
+const int WINDOW_CHANNELS = 4;
+const int WINDOW_LENGTH = 8192;
+const int BURST_FRAMES = 256;
+const int BURST_GAP_MICROSECONDS = 50;
+
+void checkWindows() {
+    HistoryRing<int, 4> ring;
+    for (int i = 1; i <= 10; i++) ring.push(i);
+    CHECK(ring.count() == 10);
+    CHECK(ring.latest() == 10);
+    for (int i = 0; i < 4; i++) CHECK(ring.window()[i] == 7 + i);
+    for (int s = 0; s < 4; s++) CHECK(ring.mirror()[s] == ring.mirror()[s + 4]);
+
+    SoAHistoryRing<float, 3, 4> soa;
+    float out[3] = {-1.0f, -1.0f, -1.0f};
+    CHECK(soa.snapshotLatest(out) == 0);
+    CHECK(out[0] == -1.0f);
+    for (int i = 1; i <= 6; i++) {
+        const float values[3] = {float(i), float(10 * i), float(100 * i)};
+        soa.push(values);
+    }
+    for (int i = 0; i < 4; i++) CHECK(soa.window(1)[i] == float(10 * (3 + i)));
+    CHECK(soa.latest(2) == 600.0f);
+    CHECK(soa.snapshotLatest(out) == 6);
+    CHECK(out[0] == 6.0f && out[1] == 60.0f && out[2] == 600.0f);
+
+    float window[4];
+    CHECK(soa.snapshotWindow(1, window) == 6);
+    for (int i = 0; i < 4; i++) CHECK(window[i] == float(10 * (3 + i)));
+
+    // Frames 4 and 5 (values 5, 6), then everything still held (3..6).
+    float since[3 * 4];
+    CHECK(soa.snapshotSince(4, since, 4) == 6);
+    CHECK(since[0] == 5.0f && since[1] == 6.0f && since[4] == 50.0f && since[9] == 600.0f);
+    CHECK(soa.snapshotSince(0, since, 4) == 6);
+    for (int i = 0; i < 4; i++) CHECK(since[4 + i] == float(10 * (3 + i)));
+}
+
+// The writer pushes frames whose channels all hold the frame number.
+void checkConcurrentSnapshots() {
+    SoAHistoryRing<uint64_t, CHANNELS, LENGTH> ring;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> pushed{0};
+    std::thread writer([&] {
+        uint64_t frame[CHANNELS];
+        uint64_t n = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            n++;
+            for (int c = 0; c < CHANNELS; c++) frame[c] = n;
+            ring.push(frame);
+        }
+        pushed = n;
+    });
+
+    uint64_t snapshots = 0, torn = 0, backwards = 0, last = 0;
+    uint64_t out[CHANNELS];
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start <
+           std::chrono::milliseconds(RACE_MILLISECONDS)) {
+        const uint64_t count = ring.snapshotLatest(out);
+        if (count == 0) continue;
+        for (int c = 0; c < CHANNELS; c++) torn += out[c] != count;
+        backwards += count < last;
+        last = count;
+        snapshots++;
+    }
+    stop = true;
+    writer.join();
+    CHECK(snapshots > 0);
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(ring.snapshotLatest(out) == pushed.load());
+}
+
+// Pushes frames whose channels all hold the frame number (frame f holds
+// f + 1) in bursts until stop.
+template<typename Ring>
+void pushBursts(Ring &ring, const std::atomic<bool> &stop) {
+    uint64_t frame[Ring::kChannels];
+    uint64_t n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        for (int b = 0; b < BURST_FRAMES; b++) {
+            n++;
+            for (uint64_t &value : frame) value = n;
+            ring.push(frame);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(BURST_GAP_MICROSECONDS));
+    }
+}
+
+// Whole windows of one channel at a time; slots not yet written read as 0.
+void checkConcurrentWindows() {
+    std::unique_ptr<SoAHistoryRing<uint64_t, WINDOW_CHANNELS, WINDOW_LENGTH>> ring =
+            std::make_unique<SoAHistoryRing<uint64_t, WINDOW_CHANNELS, WINDOW_LENGTH>>();
+    std::atomic<bool> stop{false};
+    std::thread writer([&] { pushBursts(*ring, stop); });
+
+    uint64_t snapshots = 0, wrong = 0, backwards = 0, last = 0;
+    std::vector<uint64_t> out(WINDOW_LENGTH);
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start <
+           std::chrono::milliseconds(RACE_MILLISECONDS)) {
+        const uint64_t count = ring->snapshotWindow(snapshots % WINDOW_CHANNELS, out.data());
+        backwards += count < last;
+        last = count;
+        // Slot i holds frame count - WINDOW_LENGTH + i, whose value is one more.
+        for (int i = 0; i < WINDOW_LENGTH; i++) {
+            const uint64_t expected = count + i + 1 > uint64_t(WINDOW_LENGTH) ? count + i + 1 - WINDOW_LENGTH : 0;
+            wrong += out[i] != expected;
+        }
+        snapshots++;
+    }
+    stop = true;
+    writer.join();
+    CHECK(snapshots > 0);
+    CHECK(last > uint64_t(WINDOW_LENGTH)); // the ring has wrapped
+    CHECK(wrong == 0);
+    CHECK(backwards == 0);
+}
+
+// A reader following the writer as the spectrogram upload does: each copy
+// continues from where the last one ended, and every other one is a full
+// window, as after a lost context, so copies are long enough to overlap
+// pushes even on one core.
+void checkConcurrentSince() {
+    std::unique_ptr<SoAHistoryRing<uint64_t, SINCE_CHANNELS, SINCE_LENGTH>> ring =
+            std::make_unique<SoAHistoryRing<uint64_t, SINCE_CHANNELS, SINCE_LENGTH>>();
+    std::atomic<bool> stop{false};
+    std::thread writer([&] { pushBursts(*ring, stop); });
+
+    uint64_t snapshots = 0, wrong = 0, backwards = 0, uploaded = 0;
+    std::vector<uint64_t> out(SINCE_CHANNELS * SINCE_LENGTH);
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start <
+           std::chrono::milliseconds(RACE_MILLISECONDS)) {
+        const uint64_t since = snapshots % 2 ? 0 : uploaded;
+        const uint64_t count = ring->snapshotSince(since, out.data(), SINCE_LENGTH);
+        backwards += count < uploaded;
+        const uint64_t first = count - since > uint64_t(SINCE_LENGTH) ? count - SINCE_LENGTH : since;
+        // Frame f holds f + 1 in every channel.
+        for (int c = 0; c < SINCE_CHANNELS; c++) {
+            for (uint64_t i = 0; i < count - first; i++) wrong += out[c * SINCE_LENGTH + i] != first + i + 1;
+        }
+        uploaded = count;
+        snapshots++;
+    }
+    stop = true;
+    writer.join();
+    CHECK(snapshots > 0);
+    CHECK(uploaded > 0);
+    CHECK(wrong == 0);
+    CHECK(backwards == 0);
+}
+
+// Checked after every push, so on, before and after each level's bucket
+// boundaries, while the windows fill and once they have wrapped.
+void checkPyramid() {
+    const int length = 8;
+    const int levels = 4;
+    MinMaxPyramid<length, levels> pyramid;
+    std::mt19937 random(27);
+    std::uniform_real_distribution<float> values(-10.0f, 10.0f);
+    std::vector<float> raw;
+    int mismatches = 0;
+    for (int n = 0; n < 3 * (length << levels); n++) {
+        raw.push_back(values(random));
+        pyramid.push(raw.back());
+        for (int level = 1; level <= levels; level++) {
+            const int bucket = 1 << level;
+            const int completed = int(raw.size()) / bucket;
+            const float *window = pyramid.window(level);
+            for (int b = 0; b < length; b++) {
+                // Buckets before the first completed one read as (0, 0).
+                const int first = (completed - length + b) * bucket;
+                float min = 0.0f, max = 0.0f;
+                if (first >= 0) {
+                    min = *std::min_element(&raw[first], &raw[first] + bucket);
+                    max = *std::max_element(&raw[first], &raw[first] + bucket);
+                }
+                mismatches += window[2 * b] != min || window[2 * b + 1] != max;
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+} // namespace
+
+int main() {
+    checkWindows();
+    checkConcurrentSnapshots();
+    checkConcurrentWindows();
+    checkConcurrentSince();
+    checkPyramid();
+    return testFailures();
+}
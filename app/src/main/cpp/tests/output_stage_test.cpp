@@ -0,0 +1,139 @@
+// OutputStage: no sample out above OUTPUT_CEILING for hot input, steps and
+// noise; exactly DSP_BLOCK_FRAMES frames of added latency; DC blocked;
+// gain reduction reported and released; silence in takes the settled
+// fast path.
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "output_stage.h"
+#include "test_check.h"
+
+namespace {
+
+const float RATE = 48000.0f;
+const int SAMPLES = 2 * DSP_BLOCK_FRAMES;
+const int ONE_SECOND = int(RATE) / DSP_BLOCK_FRAMES; // blocks
+
+struct Stage {
+    OutputStage output;
+    alignas(DSP_BLOCK_ALIGNMENT) float block[SAMPLES];
+
+    Stage() { output.prepare(RATE); }
+
+    // Processes one block of fill(sample index within the block) and
+    // returns its peak.
+    template<typename Fill>
+    float run(Fill fill) {
+        for (int i = 0; i < SAMPLES; i++) block[i] = fill(i);
+        output.process(block);
+        float peak = 0.0f;
+        for (float s : block) peak = std::max(peak, std::fabs(s));
+        return peak;
+    }
+
+    float silence() {
+        return run([](int) { return 0.0f; });
+    }
+};
+
+} // namespace
+
+int main() {
+    // Hot steps: 0 to +-4 inside a block, held, then back.
+    {
+        Stage stage;
+        float peak = 0.0f;
+        for (int b = 0; b < 4; b++) peak = std::max(peak, stage.silence());
+        peak = std::max(peak, stage.run([](int i) { return i < SAMPLES / 2 ? 0.0f : 4.0f; }));
+        for (int b = 0; b < ONE_SECOND; b++) {
+            peak = std::max(peak, stage.run([b](int i) { return (b / 8 + i / 32) % 2 ? 4.0f : -4.0f; }));
+        }
+        peak = std::max(peak, stage.run([](int i) { return i < 7 ? -4.0f : 0.0f; }));
+        for (int b = 0; b < ONE_SECOND; b++) peak = std::max(peak, stage.silence());
+        CHECK(peak <= OUTPUT_CEILING);
+        CHECK(peak > 0.9f * OUTPUT_CEILING);
+    }
+
+    // Noise at levels from quiet to far over, changing every block.
+    {
+        Stage stage;
+        std::mt19937 random(50);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> level(0.1f, 8.0f);
+        float peak = 0.0f;
+        for (int b = 0; b < 4 * ONE_SECOND; b++) {
+            const float gain = level(random);
+            peak = std::max(peak, stage.run([&](int) { return gain * noise(random); }));
+        }
+        CHECK(peak <= OUTPUT_CEILING);
+    }
+
+    // An impulse below the ceiling comes out unchanged one block later;
+    // the DC blocker passes the first sample of a step as is.
+    {
+        Stage stage;
+        const int frame = 10;
+        std::vector<float> out;
+        stage.run([](int i) { return i == 2 * frame ? 0.5f : 0.0f; });
+        out.insert(out.end(), stage.block, stage.block + SAMPLES);
+        for (int b = 0; b < 2; b++) {
+            stage.silence();
+            out.insert(out.end(), stage.block, stage.block + SAMPLES);
+        }
+        const int delayed = 2 * (frame + DSP_BLOCK_FRAMES);
+        bool quietBefore = true;
+        for (int i = 0; i < delayed; i++) quietBefore = quietBefore && out[i] == 0.0f;
+        CHECK(quietBefore);
+        CHECK(out[delayed] == 0.5f);
+        CHECK(out[delayed + 1] == 0.0f);
+    }
+
+    // A DC offset decays away (10 Hz corner: well under 1% after a second).
+    {
+        Stage stage;
+        float first = 0.0f;
+        float last = 0.0f;
+        for (int b = 0; b < ONE_SECOND; b++) {
+            last = stage.run([](int) { return 0.5f; });
+            if (b == 1) first = last;
+        }
+        CHECK(first > 0.4f);
+        CHECK(last < 0.005f);
+    }
+
+    // Gain reduction while limiting a 2.0 square, then released.
+    {
+        Stage stage;
+        CHECK(stage.output.gainReductionDb() == 0.0f);
+        for (int b = 0; b < 20; b++) stage.run([](int i) { return (i / 32) % 2 ? 2.0f : -2.0f; });
+        const float expected = 20.0f * std::log10(2.0f / OUTPUT_CEILING);
+        CHECK(std::fabs(stage.output.gainReductionDb() - expected) < 0.5f);
+        CHECK(stage.output.maxGainReductionDb() >= stage.output.gainReductionDb());
+        CHECK(stage.output.limitedBlocks() > 0);
+        for (int b = 0; b < ONE_SECOND; b++) stage.silence();
+        CHECK(stage.output.gainReductionDb() < 0.01f);
+        CHECK(std::fabs(stage.output.maxGainReductionDb() - expected) < 0.5f);
+    }
+
+    // Silence takes the fast path; sound doesn't; once the held block and
+    // the DC blocker have drained, silence does again.
+    {
+        Stage stage;
+        for (float &s : stage.block) s = 0.0f;
+        CHECK(!stage.output.process(stage.block));
+        for (int i = 0; i < SAMPLES; i++) stage.block[i] = i == 0 ? 0.25f : 0.0f;
+        CHECK(stage.output.process(stage.block));
+        int blocks = 0;
+        for (; blocks < 2 * ONE_SECOND; blocks++) {
+            for (float &s : stage.block) s = 0.0f;
+            if (!stage.output.process(stage.block)) break;
+        }
+        CHECK(blocks < 2 * ONE_SECOND);
+        bool silent = true;
+        for (float s : stage.block) silent = silent && s == 0.0f;
+        CHECK(silent);
+    }
+    return testFailures();
+}
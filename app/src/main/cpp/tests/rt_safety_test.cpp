@@ -0,0 +1,105 @@
+// Runs the synth and output stage through AudioOutput on miniaudio's null
+// backend with the real-time safety checker compiled in, and fails on any
+// allocation, lock or blocking call made inside the audio callback.
+#include <time.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "audio_output.h"
+#include "output_stage.h"
+#include "rt_safety.h"
+#include "synth.h"
+#include "test_check.h"
+
+namespace {
+
+const int RUN_MILLISECONDS = 400;
+
+struct Engine {
+    Synth synth;
+    OutputStage output;
+};
+
+void renderBlock(void *user, float *block) {
+    Engine *engine = (Engine *) user;
+    engine->synth.render(block);
+    engine->output.process(block);
+}
+
+// Through volatile pointers, so the compiler can't drop the pair.
+void *(*volatile allocate)(size_t) = malloc;
+void (*volatile release)(void *) = free;
+
+// The checker has to see calls made on a thread inside a scope, and only
+// those: an allocation, a free, a sleep and a print here. This file is
+// built fortified, so the print is __fprintf_chk rather than fprintf.
+void checkDetection() {
+    const uint64_t before = rtSafetyViolations();
+    release(allocate(64));
+    CHECK(rtSafetyViolations() == before);
+
+    fprintf(stderr, "rt_safety_test: %d deliberate violations follow\n", 4);
+    {
+        RT_SAFETY_SCOPE();
+        release(allocate(64));
+        const struct timespec tick = {0, 1000};
+        nanosleep(&tick, nullptr);
+        fprintf(stderr, "rt_safety_test: %s\n", "printed inside a scope");
+    }
+    CHECK(rtSafetyViolations() == before + 4);
+}
+
+void play(Engine &engine, int milliseconds) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int step = 0; std::chrono::steady_clock::now() - start <
+                       std::chrono::milliseconds(milliseconds); step++) {
+        const float t = float(step % 20) / 20.0f;
+        engine.synth.setLead(200.0f + 800.0f * t, 0.8f);
+        engine.synth.setUnison(t, 1.0f - t);
+        engine.synth.setFilter(300.0f + 6000.0f * t, 0.6f);
+        engine.synth.setGate(step % 10 < 7);
+        if (step % 5 == 0) engine.synth.trigger(330.0f, step % CHORD_COUNT, 0.5f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+} // namespace
+
+int main() {
+    checkDetection();
+    const uint64_t baseline = rtSafetyViolations();
+
+    Engine engine;
+    AudioOutput output;
+    ma_backend nullBackend = ma_backend_null;
+    CHECK(output.open(renderBlock, &engine, &nullBackend, 1));
+    CHECK(output.configure(LATENCY_PROFILE_BALANCED));
+    if (!output.configured()) return testFailures();
+
+    const float rate = float(output.info().sampleRate);
+    engine.synth.configureLead(UNISON_WAVE_SAW, 7);
+    engine.synth.configureFilter(SVF_LOWPASS);
+    engine.synth.configureEnvelope(AdsrParams());
+    engine.synth.prepare(rate);
+    engine.output.prepare(rate);
+
+    CHECK(output.start());
+    play(engine, RUN_MILLISECONDS);
+    engine.synth.setMuted(true);
+    play(engine, 50);
+    output.stop();
+    output.close();
+
+    const AudioCallbackStats::Snapshot stats = output.stats();
+    fprintf(stderr, "rt_safety_test: %llu callbacks, %llu frames, %llu silent blocks, "
+                    "%llu violations\n",
+            (unsigned long long) stats.callbacks, (unsigned long long) stats.frames,
+            (unsigned long long) engine.synth.silentBlocks(),
+            (unsigned long long) (rtSafetyViolations() - baseline));
+    CHECK(stats.callbacks > 0);
+    CHECK(engine.synth.fadedOut());
+    CHECK(rtSafetyViolations() == baseline);
+    return testFailures();
+}
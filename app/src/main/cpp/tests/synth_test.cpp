@@ -0,0 +1,155 @@
+// Synth::prewarm() between blocks, as resume() calls it while the device is
+// stopped, must leave the output bit for bit what it would have been: it
+// may only warm caches, not advance the lead, the pool voices or the
+// filter. setMuted(true) reaches fadedOut() within fadeBlocks() and
+// unmuting ramps back up, both without a step. A percussive lead (silent
+// sustain) with the gate held must end in the cheap silent path.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#include "synth.h"
+#include "test_check.h"
+
+namespace {
+
+const float RATE = 48000.0f;
+const int BLOCKS_BEFORE = 40;
+const int BLOCKS_AFTER = 200;
+const int SAMPLES = 2 * DSP_BLOCK_FRAMES;
+
+std::unique_ptr<Synth> playingSynth() {
+    std::unique_ptr<Synth> synth = std::make_unique<Synth>();
+    synth->configureLead(UNISON_WAVE_SAW, 7);
+    synth->configureFilter(SVF_LOWPASS);
+    synth->configureEnvelope(AdsrParams{0.01f, 0.15f, 0.7f, 0.5f});
+    synth->setLead(220.0f, 0.2f);
+    synth->setUnison(0.4f, 0.6f);
+    synth->setFilter(1800.0f, 0.5f);
+    synth->prepare(RATE);
+    synth->setGate(true);
+    synth->trigger(330.0f, CHORD_MAJOR, 0.3f);
+    return synth;
+}
+
+// Tracks the largest sample and the largest jump between consecutive
+// left-channel samples, across blocks.
+struct Shape {
+    float peak = 0.0f;
+    float jump = 0.0f;
+    float last = 0.0f;
+
+    void add(const float *block) {
+        for (int f = 0; f < DSP_BLOCK_FRAMES; f++) {
+            peak = std::max(peak, std::fabs(block[2 * f]));
+            jump = std::max(jump, std::fabs(block[2 * f] - last));
+            last = block[2 * f];
+        }
+    }
+
+    void restart() {
+        peak = 0.0f;
+        jump = 0.0f;
+    }
+};
+
+void checkFades() {
+    // A plain sine, so the steady jump between samples is small and a step
+    // in the gain would stand out.
+    std::unique_ptr<Synth> synth = std::make_unique<Synth>();
+    synth->configureLead(UNISON_WAVE_SINE, 1);
+    synth->setLead(220.0f, 0.2f);
+    synth->prepare(RATE);
+    synth->setGate(true);
+    alignas(DSP_BLOCK_ALIGNMENT) float block[SAMPLES];
+    Shape shape;
+    for (int b = 0; b < int(RATE) / DSP_BLOCK_FRAMES; b++) synth->render(block);
+    shape.last = block[SAMPLES - 2];
+    for (int b = 0; b < 20; b++) {
+        synth->render(block);
+        shape.add(block);
+    }
+    const float steadyPeak = shape.peak;
+    const float steadyJump = shape.jump;
+    CHECK(steadyPeak > 0.05f);
+
+    const int fadeBlocks = synth->fadeBlocks();
+    CHECK(fadeBlocks == int(std::ceil(SYNTH_FADE_SECONDS * RATE / DSP_BLOCK_FRAMES)));
+    synth->setMuted(true);
+    CHECK(!synth->fadedOut());
+    shape.restart();
+    int blocks = 0;
+    while (!synth->fadedOut() && blocks <= fadeBlocks) {
+        synth->render(block);
+        shape.add(block);
+        blocks++;
+    }
+    CHECK(synth->fadedOut());
+    CHECK(blocks <= fadeBlocks);
+    CHECK(shape.jump <= 1.05f * steadyJump);
+    synth->render(block);
+    CHECK(std::all_of(block, block + SAMPLES, [](float s) { return s == 0.0f; }));
+
+    synth->setMuted(false);
+    CHECK(!synth->fadedOut());
+    shape.last = 0.0f;
+    shape.restart();
+    synth->render(block);
+    shape.add(block);
+    // The first block ends at one fade step of gain.
+    CHECK(shape.peak <= 1.05f * steadyPeak / float(fadeBlocks));
+    for (int b = 1; b < fadeBlocks; b++) {
+        synth->render(block);
+        shape.add(block);
+    }
+    CHECK(shape.jump <= 1.05f * steadyJump);
+    shape.restart();
+    for (int b = 0; b < 20; b++) {
+        synth->render(block);
+        shape.add(block);
+    }
+    CHECK(shape.peak > 0.95f * steadyPeak);
+}
+
+} // namespace
+
+int main() {
+    std::unique_ptr<Synth> plain = playingSynth();
+    std::unique_ptr<Synth> prewarmed = playingSynth();
+    alignas(DSP_BLOCK_ALIGNMENT) float expected[SAMPLES];
+    alignas(DSP_BLOCK_ALIGNMENT) float actual[SAMPLES];
+
+    for (int b = 0; b < BLOCKS_BEFORE; b++) {
+        plain->render(expected);
+        prewarmed->render(actual);
+    }
+    prewarmed->prewarm();
+
+    int differing = 0;
+    bool audible = false;
+    for (int b = 0; b < BLOCKS_AFTER; b++) {
+        plain->render(expected);
+        prewarmed->render(actual);
+        if (std::memcmp(expected, actual, sizeof(expected)) != 0) differing++;
+        for (float s : expected) audible = audible || s != 0.0f;
+    }
+    CHECK(audible);
+    CHECK(differing == 0);
+    CHECK(plain->activeVoices() == prewarmed->activeVoices());
+
+    // 0.15 s decay time constant: inaudible after about 1.4 s.
+    std::unique_ptr<Synth> percussive = std::make_unique<Synth>();
+    percussive->configureEnvelope(AdsrParams{0.01f, 0.15f, 0.0f, 0.5f});
+    percussive->setLead(220.0f, 0.2f);
+    percussive->prepare(RATE);
+    percussive->setGate(true);
+    const int twoSeconds = int(2.0f * RATE) / DSP_BLOCK_FRAMES;
+    for (int b = 0; b < twoSeconds; b++) percussive->render(actual);
+    const uint64_t silentBefore = percussive->silentBlocks();
+    for (int b = 0; b < 10; b++) percussive->render(actual);
+    CHECK(percussive->silentBlocks() - silentBefore == 10);
+
+    checkFades();
+    return testFailures();
+}
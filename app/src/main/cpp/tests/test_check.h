@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+/*
+ * CHECK(condition)
+ *    Assertion for the host tests that keeps going: a failed condition is
+ *    printed with its location and counted, and main() returns
+ *    testFailures() so ctest sees the run fail.
+ */
+inline int &testFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int testFailures() {
+    if (testFailureCount() > 0) fprintf(stderr, "%d check(s) failed\n", testFailureCount());
+    return testFailureCount() > 0 ? 1 : 0;
+}
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailureCount()++;                                                 \
+        }                                                                         \
+    } while (0)
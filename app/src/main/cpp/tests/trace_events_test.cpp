@@ -0,0 +1,232 @@
+// Trace events from two threads, dumped with traceDumpJson: the file is
+// valid JSON, every thread has its thread_name, its begin / end events
+// balance and its counters are there. SIGUSR1 followed by tracePollDump()
+// writes the same dump to the installed path. Built with trace_events.cpp
+// and THERECELL_TRACING regardless of the CMake option.
+#include <signal.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_check.h"
+#include "trace_events.h"
+
+namespace {
+
+const int SCOPES = 500; // per thread, well inside TRACE_EVENTS_PER_THREAD
+
+// Each event object's scalar members, as their JSON text (strings
+// unquoted); nested objects are validated but flattened as "args.name".
+using Event = std::map<std::string, std::string>;
+
+// Just enough of a JSON parser to reject a malformed dump and pull out
+// the traceEvents array.
+struct Json {
+    const std::string &text;
+    size_t at = 0;
+    bool ok = true;
+
+    void space() {
+        while (at < text.size() && std::isspace((unsigned char) text[at])) at++;
+    }
+
+    bool take(char c) {
+        space();
+        if (at < text.size() && text[at] == c) {
+            at++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!take(c)) ok = false;
+    }
+
+    std::string string() {
+        std::string out;
+        expect('"');
+        while (ok && at < text.size() && text[at] != '"') {
+            if (text[at] == '\\') at++;
+            if (at < text.size()) out += text[at++];
+        }
+        expect('"');
+        return out;
+    }
+
+    std::string scalar() {
+        space();
+        const size_t start = at;
+        while (at < text.size() && (std::isalnum((unsigned char) text[at]) ||
+                                    text[at] == '-' || text[at] == '+' || text[at] == '.')) {
+            at++;
+        }
+        const std::string word = text.substr(start, at - start);
+        if (word.empty()) ok = false;
+        if (word != "true" && word != "false" && word != "null") {
+            char *end = nullptr;
+            std::strtod(word.c_str(), &end);
+            if (end != word.c_str() + word.size()) ok = false;
+        }
+        return word;
+    }
+
+    // Parses any value; members of objects are added to event under
+    // prefix + key, and the elements of "traceEvents" to events.
+    std::string value(Event &event, const std::string &prefix, std::vector<Event> *events) {
+        space();
+        if (at >= text.size()) {
+            ok = false;
+            return {};
+        }
+        if (text[at] == '"') return string();
+        if (take('{')) {
+            if (take('}')) return {};
+            do {
+                const std::string key = string();
+                expect(':');
+                if (key == "traceEvents" && events) {
+                    expect('[');
+                    if (!take(']')) {
+                        do {
+                            Event element;
+                            space();
+                            if (at >= text.size() || text[at] != '{') ok = false;
+                            value(element, "", nullptr);
+                            events->push_back(element);
+                        } while (ok && take(','));
+                        expect(']');
+                    }
+                } else {
+                    event[prefix + key] = value(event, prefix + key + ".", events);
+                }
+            } while (ok && take(','));
+            expect('}');
+            return {};
+        }
+        if (take('[')) {
+            if (take(']')) return {};
+            do {
+                value(event, prefix, nullptr);
+            } while (ok && take(','));
+            expect(']');
+            return {};
+        }
+        return scalar();
+    }
+
+    bool parse(std::vector<Event> &events) {
+        Event top;
+        value(top, "", &events);
+        space();
+        return ok && at == text.size();
+    }
+};
+
+std::string readFile(const char *path) {
+    std::ifstream in(path);
+    std::stringstream out;
+    out << in.rdbuf();
+    return out.str();
+}
+
+void traceThread(const char *name, const char *counter) {
+    TRACE_THREAD_NAME(name);
+    for (int i = 0; i < SCOPES; i++) {
+        TRACE_SCOPE("outer");
+        TRACE_COUNTER(counter, i);
+        TRACE_SCOPE("inner");
+    }
+}
+
+struct PerThread {
+    std::string name;
+    int begins = 0;
+    int depth = 0;
+    bool negative = false;
+    int counters = 0;
+};
+
+// Parses path and checks it holds the two threads' events; the main
+// thread's own events, if any, are ignored.
+void checkDump(const char *path) {
+    const std::string text = readFile(path);
+    CHECK(!text.empty());
+    std::vector<Event> events;
+    CHECK(Json{text}.parse(events));
+
+    std::map<std::string, PerThread> threads;
+    for (Event &e : events) {
+        CHECK(e.count("ph") == 1 && e.count("pid") == 1 && e.count("tid") == 1);
+        PerThread &thread = threads[e["tid"]];
+        const std::string &phase = e["ph"];
+        if (phase == "M") {
+            CHECK(e["name"] == "thread_name");
+            thread.name = e["args.name"];
+            continue;
+        }
+        CHECK(e.count("ts") == 1);
+        if (phase == "B") {
+            thread.begins++;
+            thread.depth++;
+        } else if (phase == "E") {
+            thread.depth--;
+            thread.negative = thread.negative || thread.depth < 0;
+        } else if (phase == "C") {
+            thread.counters++;
+            CHECK(e.count("args.value") == 1);
+        } else {
+            CHECK(!"unexpected phase");
+        }
+    }
+
+    int found = 0;
+    for (const auto &entry : threads) {
+        const PerThread &thread = entry.second;
+        if (thread.name != "first" && thread.name != "second") continue;
+        found++;
+        CHECK(thread.begins == 2 * SCOPES);
+        CHECK(thread.depth == 0);
+        CHECK(!thread.negative);
+        CHECK(thread.counters == SCOPES);
+    }
+    CHECK(found == 2);
+}
+
+} // namespace
+
+int main() {
+    std::thread first(traceThread, "first", "first count");
+    std::thread second(traceThread, "second", "second count");
+    first.join();
+    second.join();
+
+    char path[64];
+    snprintf(path, sizeof(path), "trace_events_test.%d.json", int(getpid()));
+    CHECK(traceDumpJson(path));
+    checkDump(path);
+    std::remove(path);
+
+    // The handler only sets a flag: nothing is written until the poll.
+    char signalPath[64];
+    snprintf(signalPath, sizeof(signalPath), "trace_events_test.%d.signal.json", int(getpid()));
+    traceInstallSignalHandler(signalPath);
+    tracePollDump();
+    CHECK(readFile(signalPath).empty());
+    raise(SIGUSR1);
+    CHECK(readFile(signalPath).empty());
+    tracePollDump();
+    checkDump(signalPath);
+    std::remove(signalPath);
+
+    CHECK(!traceDumpJson("/nonexistent/trace.json"));
+    return testFailures();
+}
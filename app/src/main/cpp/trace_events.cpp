@@ -0,0 +1,179 @@
+// Only built with THERECELL_TRACING; see trace_events.h.
+#include "trace_events.h"
+
+#if !THERECELL_TRACING
+#error "trace_events.cpp needs THERECELL_TRACING"
+#endif
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "logging.h"
+
+namespace {
+
+enum EventType : uint32_t {
+    EVENT_BEGIN,
+    EVENT_END,
+    EVENT_COUNTER,
+};
+
+struct Event {
+    int64_t timestampNs;
+    const char *name;
+    float value;
+    EventType type;
+};
+
+enum SlotState : int {
+    SLOT_FREE,
+    SLOT_LIVE,
+    SLOT_EXITED, // events kept for dumps until another thread reuses the slot
+};
+
+struct ThreadBuffer {
+    std::atomic<int> state{SLOT_FREE};
+    std::atomic<uint64_t> written{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<int> tid{0};
+    Event events[TRACE_EVENTS_PER_THREAD];
+};
+
+static_assert((TRACE_EVENTS_PER_THREAD & (TRACE_EVENTS_PER_THREAD - 1)) == 0,
+              "TRACE_EVENTS_PER_THREAD must be a power of two");
+
+ThreadBuffer buffers[TRACE_MAX_THREADS];
+
+// A pthread key rather than thread_local: with minSdk below 29 the NDK
+// emulates thread_local and allocates on a thread's first access, which
+// would happen inside the audio callback.
+pthread_key_t bufferKey;
+const bool keyCreated = pthread_key_create(&bufferKey, [](void *slot) {
+    static_cast<ThreadBuffer *>(slot)->state.store(SLOT_EXITED);
+}) == 0;
+
+ThreadBuffer *claimBuffer() {
+    for (ThreadBuffer &buffer : buffers) {
+        int expected = SLOT_FREE;
+        if (buffer.state.compare_exchange_strong(expected, SLOT_LIVE)) return &buffer;
+    }
+    for (ThreadBuffer &buffer : buffers) {
+        int expected = SLOT_EXITED;
+        if (buffer.state.compare_exchange_strong(expected, SLOT_LIVE)) {
+            buffer.written.store(0);
+            buffer.name.store(nullptr);
+            return &buffer;
+        }
+    }
+    return nullptr; // all slots live: this thread is not traced
+}
+
+ThreadBuffer *currentBuffer() {
+    if (!keyCreated) return nullptr;
+    ThreadBuffer *buffer = static_cast<ThreadBuffer *>(pthread_getspecific(bufferKey));
+    if (buffer) return buffer;
+    buffer = claimBuffer();
+    if (!buffer) return nullptr;
+    buffer->tid.store(int(syscall(SYS_gettid)));
+    pthread_setspecific(bufferKey, buffer);
+    return buffer;
+}
+
+void record(EventType type, const char *name, float value) {
+    ThreadBuffer *buffer = currentBuffer();
+    if (!buffer) return;
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    uint64_t count = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[count & (TRACE_EVENTS_PER_THREAD - 1)] = {now, name, value, type};
+    buffer->written.store(count + 1, std::memory_order_release);
+}
+
+std::atomic<bool> dumpRequested{false};
+char signalDumpPath[256];
+
+} // namespace
+
+void traceBegin(const char *name) { record(EVENT_BEGIN, name, 0.0f); }
+
+void traceEnd() { record(EVENT_END, nullptr, 0.0f); }
+
+void traceCounter(const char *name, double value) { record(EVENT_COUNTER, name, float(value)); }
+
+void traceThreadName(const char *name) {
+    ThreadBuffer *buffer = currentBuffer();
+    if (buffer) buffer->name.store(name, std::memory_order_relaxed);
+}
+
+bool traceDumpJson(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        LOGI("trace: cannot write %s", path);
+        return false;
+    }
+    const int pid = int(getpid());
+    // Skip the oldest part of a full ring; its writer may be overwriting it.
+    const uint64_t margin = TRACE_EVENTS_PER_THREAD / 16;
+    uint64_t total = 0;
+    bool first = true;
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (const ThreadBuffer &buffer : buffers) {
+        if (buffer.state.load() == SLOT_FREE) continue;
+        const int tid = buffer.tid.load();
+        const char *threadName = buffer.name.load();
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", pid, tid, threadName ? threadName : "thread");
+        first = false;
+        const uint64_t end = buffer.written.load(std::memory_order_acquire);
+        const uint64_t begin = end > uint64_t(TRACE_EVENTS_PER_THREAD)
+                               ? end - TRACE_EVENTS_PER_THREAD + margin : 0;
+        for (uint64_t i = begin; i < end; i++) {
+            const Event &e = buffer.events[i & (TRACE_EVENTS_PER_THREAD - 1)];
+            const double us = double(e.timestampNs) / 1000.0;
+            switch (e.type) {
+                case EVENT_BEGIN:
+                    fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                            e.name, us, pid, tid);
+                    break;
+                case EVENT_END:
+                    fprintf(out, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", us, pid, tid);
+                    break;
+                case EVENT_COUNTER:
+                    fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                                 "\"args\":{\"value\":%g}}",
+                            e.name, us, pid, tid, double(e.value));
+                    break;
+            }
+        }
+        total += end - begin;
+    }
+    fprintf(out, "\n]}\n");
+    bool ok = fclose(out) == 0;
+    LOGI("trace: wrote %llu events to %s", (unsigned long long) total, path);
+    return ok;
+}
+
+void traceInstallSignalHandler(const char *path) {
+#if defined(__linux__) && !defined(__ANDROID__)
+    strncpy(signalDumpPath, path, sizeof(signalDumpPath) - 1);
+    struct sigaction action = {};
+    action.sa_handler = [](int) { dumpRequested.store(true); };
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+#else
+    (void) path;
+#endif
+}
+
+void tracePollDump() {
+    if (dumpRequested.exchange(false)) traceDumpJson(signalDumpPath);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Trace events (THERECELL_TRACING)
+ *    Timeline of begin / end / counter events for the GL, audio, sensor and
+ *    analyzer threads, exported as Chrome trace JSON (chrome://tracing,
+ *    ui.perfetto.dev). Each thread records into its own fixed ring from a
+ *    static pool, so recording is a clock read, a few stores and one
+ *    release store: no locks, no allocation, safe in the audio callback.
+ *    Names must be string literals; only the pointer is stored.
+ *
+ *    With the option off every macro compiles to nothing.
+ */
+#if THERECELL_TRACING
+
+const int TRACE_MAX_THREADS = 16;
+const int TRACE_EVENTS_PER_THREAD = 16384; // power of two; oldest are overwritten
+
+void traceBegin(const char *name);
+void traceEnd();
+void traceCounter(const char *name, double value);
+void traceThreadName(const char *name);
+
+// Writes every thread's ring as Chrome trace JSON; false if path can't be written.
+bool traceDumpJson(const char *path);
+
+// Linux: SIGUSR1 requests a dump to path, performed by the next
+// tracePollDump() on a normal thread (the handler itself only sets a flag).
+void traceInstallSignalHandler(const char *path);
+void tracePollDump();
+
+struct TraceScope {
+    explicit TraceScope(const char *name) { traceBegin(name); }
+    ~TraceScope() { traceEnd(); }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_COUNTER(name, value) traceCounter(name, double(value))
+#define TRACE_THREAD_NAME(name) traceThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+
+inline bool traceDumpJson(const char *) { return false; }
+inline void traceInstallSignalHandler(const char *) {}
+inline void tracePollDump() {}
+
+#endif
@@ -0,0 +1,325 @@
+#include "trace_renderer.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "gl_program.h"
+
+namespace {
+
+void traceColors(const SensorHistories &histories,
+                 GLfloat (&colors)[TraceRenderer::TRACE_COUNT][4]) {
+    // Alpha 0 hides the traces of sensors this device does not have.
+    const GLfloat gyroAlpha = histories.hasGyro ? 1.0f : 0.0f;
+    const GLfloat proxAlpha = histories.hasProx ? 1.0f : 0.0f;
+    const GLfloat table[TraceRenderer::TRACE_COUNT][4] = {
+            {1.0f, 1.0f, 0.0f, 1.0f},      // accel x: yellow
+            {1.0f, 0.0f, 1.0f, 1.0f},      // accel y: magenta
+            {0.0f, 1.0f, 1.0f, 1.0f},      // accel z: cyan
+            {0.6f, 0.6f, 0.0f, gyroAlpha}, // gyro x: darker yellow
+            {0.6f, 0.0f, 0.6f, gyroAlpha}, // gyro y: darker magenta
+            {0.0f, 0.6f, 0.6f, gyroAlpha}, // gyro z: darker cyan
+            {1.0f, 1.0f, 1.0f, proxAlpha}, // proximity: white
+    };
+    memcpy(colors, table, sizeof(table));
+}
+
+} // namespace
+
+void TraceRenderer::surfaceCreated(const TraceShaders &shaders,
+                                   const SensorHistories &histories) {
+    const char *version = (const char *) glGetString(GL_VERSION);
+    useHistoryTexture = historyTextureAllowed && version != nullptr &&
+                        strncmp(version, "OpenGL ES 3", 11) == 0;
+    if (useHistoryTexture) {
+        createTextureRenderer(shaders, histories);
+    } else {
+        createSegmentRenderer(shaders, histories);
+    }
+    useLodLevel(histories.lodLevel());
+}
+
+// Sizes the traces for raw history (level 0) or a min/max envelope, with
+// the program bound. GL objects die with the context and the layout
+// changes with the level, so either way the next sync is a full upload.
+void TraceRenderer::useLodLevel(int level) {
+    lodLevel = level;
+    tracePoints = level > 0 ? MAX_TRACE_POINTS : SENSOR_HISTORY_LENGTH;
+    traceVertices = tracePoints * 2;
+    const GLint pointsPerColumn = tracePoints / SENSOR_HISTORY_LENGTH;
+    accelUploaded = UINT64_MAX;
+    gyroUploaded = UINT64_MAX;
+    proxUploaded = UINT64_MAX;
+    if (useHistoryTexture) {
+        glUniform1i(uPointCountHandle, tracePoints);
+        glUniform1i(uPointsPerColumnHandle, pointsPerColumn);
+        return;
+    }
+
+    glUniform1f(uPointCountHandle, GLfloat(tracePoints));
+    glUniform1f(uPointsPerColumnHandle, GLfloat(pointsPerColumn));
+    for (int t = 0; t < TRACE_COUNT; t++) {
+        for (int k = 0; k < traceVertices; k++) {
+            segmentVertices[t * traceVertices + k] = {
+                    GLfloat(k >> 1), GLfloat(k & 1), GLfloat(t)};
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, segmentBuffer);
+    glBufferData(GL_ARRAY_BUFFER, TRACE_COUNT * traceVertices * sizeof(SegmentVertex),
+                 segmentVertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, valueBuffer);
+    glBufferData(GL_ARRAY_BUFFER, TRACE_COUNT * traceVertices * sizeof(GLfloat), nullptr,
+                 level > 0 ? GL_STREAM_DRAW : GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TraceRenderer::createSegmentRenderer(const TraceShaders &shaders,
+                                          const SensorHistories &histories) {
+    shaderProgram = createProgram(shaders.segmentVertex, shaders.segmentFragment);
+    assert(shaderProgram != 0);
+    GLint getSegmentLocationResult =
+            glGetAttribLocation(shaderProgram, "vSegment");
+    assert(getSegmentLocationResult != -1);
+    vSegmentHandle = (GLuint) getSegmentLocationResult;
+    GLint getSensorValueLocationResult =
+            glGetAttribLocation(shaderProgram, "vSensorValue");
+    assert(getSensorValueLocationResult != -1);
+    vSensorValueHandle = (GLuint) getSensorValueLocationResult;
+    uTraceColorsHandle = glGetUniformLocation(shaderProgram, "uTraceColors");
+    assert(uTraceColorsHandle != -1);
+    uHeadHandle = glGetUniformLocation(shaderProgram, "uHead");
+    assert(uHeadHandle != -1);
+    uPointCountHandle = glGetUniformLocation(shaderProgram, "uPointCount");
+    assert(uPointCountHandle != -1);
+    uPointsPerColumnHandle = glGetUniformLocation(shaderProgram, "uPointsPerColumn");
+    assert(uPointsPerColumnHandle != -1);
+
+    GLfloat colors[TRACE_COUNT][4];
+    traceColors(histories, colors);
+    glUseProgram(shaderProgram);
+    glUniform4fv(uTraceColorsHandle, TRACE_COUNT, &colors[0][0]);
+
+    // Filled by useLodLevel().
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    segmentBuffer = buffers[0];
+    valueBuffer = buffers[1];
+}
+
+void TraceRenderer::createTextureRenderer(const TraceShaders &shaders,
+                                          const SensorHistories &histories) {
+    shaderProgram = createProgram(shaders.textureVertex, shaders.textureFragment);
+    assert(shaderProgram != 0);
+    uHistoryHandle = glGetUniformLocation(shaderProgram, "uHistory");
+    assert(uHistoryHandle != -1);
+    uTraceColorsHandle = glGetUniformLocation(shaderProgram, "uTraceColors");
+    assert(uTraceColorsHandle != -1);
+    uHeadHandle = glGetUniformLocation(shaderProgram, "uHead");
+    assert(uHeadHandle != -1);
+    uPointCountHandle = glGetUniformLocation(shaderProgram, "uPointCount");
+    assert(uPointCountHandle != -1);
+    uPointsPerColumnHandle = glGetUniformLocation(shaderProgram, "uPointsPerColumn");
+    assert(uPointsPerColumnHandle != -1);
+    uViewportHandle = glGetUniformLocation(shaderProgram, "uViewport");
+    assert(uViewportHandle != -1);
+    uHalfWidthHandle = glGetUniformLocation(shaderProgram, "uHalfWidth");
+    assert(uHalfWidthHandle != -1);
+
+    GLfloat colors[TRACE_COUNT][4];
+    traceColors(histories, colors);
+    glUseProgram(shaderProgram);
+    glUniform4fv(uTraceColorsHandle, TRACE_COUNT, &colors[0][0]);
+    glUniform1i(uHistoryHandle, 0);
+
+    // Wide enough for an envelope; raw history uses the first
+    // SENSOR_HISTORY_LENGTH texels of each row.
+    glGenTextures(1, &historyTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, historyTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, MAX_TRACE_POINTS, TRACE_COUNT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TraceRenderer::surfaceChanged(int width, int height) {
+    glViewport(0, 0, width, height);
+    viewport[0] = GLfloat(width);
+    viewport[1] = GLfloat(height);
+}
+
+void TraceRenderer::render(const SensorHistories &histories) {
+    glUseProgram(shaderProgram);
+    if (histories.lodLevel() != lodLevel) useLodLevel(histories.lodLevel());
+    if (useHistoryTexture) {
+        renderTexture(histories);
+    } else {
+        renderSegments(histories);
+    }
+    renderStats.frames++;
+}
+
+void TraceRenderer::uploadFloats(GLintptr floatOffset, const GLfloat *src,
+                                 GLsizeiptr floatCount) {
+    glBufferSubData(GL_ARRAY_BUFFER, floatOffset * sizeof(GLfloat),
+                    floatCount * sizeof(GLfloat), src);
+    renderStats.uploadCalls++;
+    renderStats.uploadBytes += floatCount * sizeof(GLfloat);
+}
+
+// Rewrites the segment endpoints touched by samples written since the last
+// sync. A sample in slot q is the start of segment q and the end of segment
+// q - 1, so the touched vertices form one circular range of 2 * fresh values
+// per trace (at most two uploads).
+void TraceRenderer::syncTraces(const GLfloat *const *mirrors, int channels, int firstTrace,
+                               uint64_t count, uint64_t &uploaded) {
+    const GLsizei n = SENSOR_HISTORY_LENGTH;
+    const GLsizei mask = n - 1;
+    if (count == uploaded) return;
+    const bool full = uploaded > count || count - uploaded >= uint64_t(n);
+    GLsizei first = full ? 0 : ((GLsizei(uploaded) - 1) & mask) * 2 + 1;
+    GLsizei length = full ? traceVertices : GLsizei(count - uploaded) * 2;
+    for (int c = 0; c < channels; c++) {
+        for (GLsizei i = 0; i < length; i++) {
+            GLsizei k = (first + i) % traceVertices;
+            traceStaging[i] = mirrors[c][((k >> 1) + (k & 1)) & mask];
+        }
+        GLintptr base = (firstTrace + c) * traceVertices;
+        GLsizei head = length < traceVertices - first ? length : traceVertices - first;
+        uploadFloats(base + first, traceStaging, head);
+        if (length > head) uploadFloats(base, traceStaging + head, length - head);
+    }
+    uploaded = count;
+}
+
+// Expands one linear min/max envelope into segment endpoints.
+void TraceRenderer::uploadEnvelope(int trace, const GLfloat *window) {
+    for (GLsizei k = 0; k < traceVertices; k++) {
+        traceStaging[k] = window[((k >> 1) + (k & 1)) % tracePoints];
+    }
+    uploadFloats(trace * traceVertices, traceStaging, traceVertices);
+}
+
+void TraceRenderer::renderSegments(const SensorHistories &histories) {
+    glBindBuffer(GL_ARRAY_BUFFER, segmentBuffer);
+    glEnableVertexAttribArray(vSegmentHandle);
+    glVertexAttribPointer(vSegmentHandle, 3, GL_FLOAT, GL_FALSE, sizeof(SegmentVertex),
+                          (const void *) 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, valueBuffer);
+    glEnableVertexAttribArray(vSensorValueHandle);
+    glVertexAttribPointer(vSensorValueHandle, 1, GL_FLOAT, GL_FALSE, 0, (const void *) 0);
+
+    GLfloat heads[TRACE_COUNT] = {};
+    if (lodLevel > 0) {
+        // The whole envelope can shift each frame, so orphan and refill.
+        glBufferData(GL_ARRAY_BUFFER, TRACE_COUNT * traceVertices * sizeof(GLfloat),
+                     nullptr, GL_STREAM_DRAW);
+        for (int c = 0; c < 3; c++) {
+            uploadEnvelope(c, histories.accelLod[c].window(lodLevel));
+            if (histories.hasGyro) {
+                uploadEnvelope(3 + c, histories.gyroLod[c].window(lodLevel));
+            }
+        }
+        if (histories.hasProx) {
+            uploadEnvelope(6, histories.proxLod.window(lodLevel));
+        }
+    } else {
+        const GLfloat *accelMirrors[3] = {
+                histories.accel.mirror(0), histories.accel.mirror(1), histories.accel.mirror(2)};
+        syncTraces(accelMirrors, 3, 0, histories.accel.count(), accelUploaded);
+        const GLfloat *gyroMirrors[3] = {
+                histories.gyro.mirror(0), histories.gyro.mirror(1), histories.gyro.mirror(2)};
+        syncTraces(gyroMirrors, 3, 3, histories.gyro.count(), gyroUploaded);
+        const GLfloat *proxMirror = histories.prox.mirror();
+        syncTraces(&proxMirror, 1, 6, histories.prox.count(), proxUploaded);
+
+        const uint64_t uploaded[TRACE_COUNT] = {
+                accelUploaded, accelUploaded, accelUploaded,
+                gyroUploaded, gyroUploaded, gyroUploaded, proxUploaded};
+        for (int t = 0; t < TRACE_COUNT; t++) {
+            heads[t] = GLfloat(uploaded[t] & SensorHistory::kMask);
+        }
+    }
+    glUniform1fv(uHeadHandle, TRACE_COUNT, heads);
+
+    glDrawArrays(GL_LINES, 0, TRACE_COUNT * traceVertices);
+    renderStats.drawCalls++;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Copies samples written since the last sync into rows
+// [firstRow, firstRow + rows) of historyTexture; at most two uploads.
+void TraceRenderer::syncTexture(const GLfloat *mirror, GLsizei rows, GLint firstRow,
+                                uint64_t count, uint64_t &uploaded) {
+    const GLsizei n = SENSOR_HISTORY_LENGTH;
+    if (count == uploaded) return;
+    const bool full = uploaded > count || count - uploaded >= uint64_t(n);
+    GLsizei from = full ? 0 : GLsizei(uploaded) & (n - 1);
+    GLsizei length = full ? n : GLsizei(count - uploaded);
+    GLsizei head = length < n - from ? length : n - from;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, from, firstRow, head, rows, GL_RED, GL_FLOAT,
+                    mirror + from);
+    renderStats.uploadCalls++;
+    if (length > head) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, length - head, rows, GL_RED,
+                        GL_FLOAT, mirror);
+        renderStats.uploadCalls++;
+    }
+    renderStats.uploadBytes += length * rows * sizeof(GLfloat);
+    uploaded = count;
+}
+
+// Copies every trace's envelope into one staging image, rows of
+// MAX_TRACE_POINTS floats, and uploads it in one call.
+void TraceRenderer::uploadEnvelopeTexture(const SensorHistories &histories) {
+    const SensorLod *lods[TRACE_COUNT] = {
+            &histories.accelLod[0], &histories.accelLod[1], &histories.accelLod[2],
+            &histories.gyroLod[0], &histories.gyroLod[1], &histories.gyroLod[2], &histories.proxLod};
+    for (int t = 0; t < TRACE_COUNT; t++) {
+        memcpy(traceStaging + t * MAX_TRACE_POINTS, lods[t]->window(lodLevel),
+               MAX_TRACE_POINTS * sizeof(GLfloat));
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, MAX_TRACE_POINTS, TRACE_COUNT, GL_RED, GL_FLOAT,
+                    traceStaging);
+    renderStats.uploadCalls++;
+    renderStats.uploadBytes += sizeof(traceStaging);
+}
+
+void TraceRenderer::renderTexture(const SensorHistories &histories) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, historyTexture);
+    // SoA channels sit 2 * SENSOR_HISTORY_LENGTH floats apart in the
+    // mirrored rings, so x/y/z rows upload in one call; envelope staging
+    // rows have the same length. Set per frame since other renderers stream
+    // textures with their own row length.
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, SENSOR_HISTORY_LENGTH * 2);
+    GLint heads[TRACE_COUNT] = {};
+    if (lodLevel > 0) {
+        // The whole envelope can shift each frame, so refill; it is drawn
+        // oldest first from column 0.
+        uploadEnvelopeTexture(histories);
+    } else {
+        syncTexture(histories.accel.mirror(0), 3, 0, histories.accel.count(), accelUploaded);
+        syncTexture(histories.gyro.mirror(0), 3, 3, histories.gyro.count(), gyroUploaded);
+        syncTexture(histories.prox.mirror(), 1, 6, histories.prox.count(), proxUploaded);
+
+        const uint64_t uploaded[TRACE_COUNT] = {
+                accelUploaded, accelUploaded, accelUploaded,
+                gyroUploaded, gyroUploaded, gyroUploaded, proxUploaded};
+        for (int t = 0; t < TRACE_COUNT; t++) {
+            heads[t] = GLint(uploaded[t] & SensorHistory::kMask);
+        }
+    }
+    glUniform1iv(uHeadHandle, TRACE_COUNT, heads);
+    glUniform2fv(uViewportHandle, 1, viewport);
+    glUniform1f(uHalfWidthHandle, 0.5f * lineWidth);
+
+    // Six vertices (two triangles) per segment; coverage goes to alpha.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, TRACE_COUNT * tracePoints * 6);
+    glDisable(GL_BLEND);
+    renderStats.drawCalls++;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+#include <string_view>
+
+#include "sensor_history.h"
+
+// Shader sources; only needs to stay valid during surfaceCreated().
+struct TraceShaders {
+    std::string_view segmentVertex;   // shader.glslv (ES 2.0)
+    std::string_view segmentFragment; // shader.glslf
+    std::string_view textureVertex;   // shader_es3.glslv (ES 3.0)
+    std::string_view textureFragment; // shader_es3.glslf
+};
+
+/*
+ * TraceRenderer
+ *    Draws accel x/y/z, gyro x/y/z and proximity from SensorHistories in a
+ *    single draw call. On an ES 3 context the history is streamed into a
+ *    float texture and the vertex shader expands every segment into an
+ *    anti-aliased quad of the configured width; otherwise each trace is a
+ *    ring of 1-pixel GL_LINES segments fed from a value VBO. Either way only
+ *    the samples written since the previous frame are uploaded.
+ *
+ *    At a histories.lodLevel() above 0 both paths draw the min/max envelope
+ *    instead, refilled every frame since the whole of it can shift; the
+ *    renderer follows level changes on the next render().
+ *
+ *    Needs nothing but a current GLES context, so it can run on device or
+ *    under a headless EGL context on the host.
+ */
+class TraceRenderer {
+public:
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t drawCalls = 0;
+        uint64_t uploadCalls = 0;
+        uint64_t uploadBytes = 0;
+    };
+
+    static constexpr int TRACE_COUNT = 7;
+
+    // (Re)creates all GL objects; call whenever a new context is current.
+    void surfaceCreated(const TraceShaders &shaders, const SensorHistories &histories);
+
+    void surfaceChanged(int width, int height);
+
+    // Trace width in pixels for the ES3 path; the ES2 fallback draws hairlines.
+    void setLineWidth(float pixels) { lineWidth = pixels; }
+
+    // Before surfaceCreated(): false keeps the ES2 path on an ES 3 context,
+    // so a harness can exercise both on one driver.
+    void allowHistoryTexture(bool allowed) { historyTextureAllowed = allowed; }
+
+    void render(const SensorHistories &histories);
+
+    const Stats &stats() const { return renderStats; }
+
+    void resetStats() { renderStats = Stats(); }
+
+private:
+    // Each trace is tracePoints ring points drawn as tracePoints segments
+    // that own both endpoints; the segment that wraps from newest to oldest
+    // is culled in the vertex shader. Raw history has SENSOR_HISTORY_LENGTH
+    // points, a min/max envelope twice that.
+    static constexpr GLsizei MAX_TRACE_POINTS = SENSOR_HISTORY_LENGTH * 2;
+    static constexpr GLsizei MAX_TRACE_VERTICES = MAX_TRACE_POINTS * 2;
+
+    struct SegmentVertex {
+        GLfloat segment, end, trace;
+    };
+
+    void createSegmentRenderer(const TraceShaders &shaders, const SensorHistories &histories);
+    void createTextureRenderer(const TraceShaders &shaders, const SensorHistories &histories);
+    void useLodLevel(int level);
+    void renderSegments(const SensorHistories &histories);
+    void renderTexture(const SensorHistories &histories);
+
+    void uploadFloats(GLintptr floatOffset, const GLfloat *src, GLsizeiptr floatCount);
+    void syncTraces(const GLfloat *const *mirrors, int channels, int firstTrace,
+                    uint64_t count, uint64_t &uploaded);
+    void uploadEnvelope(int trace, const GLfloat *window);
+    void uploadEnvelopeTexture(const SensorHistories &histories);
+    void syncTexture(const GLfloat *mirror, GLsizei rows, GLint firstRow,
+                     uint64_t count, uint64_t &uploaded);
+
+    GLuint shaderProgram = 0;
+    GLuint vSegmentHandle = 0;
+    GLuint vSensorValueHandle = 0;
+    GLint uTraceColorsHandle = -1;
+    GLint uHeadHandle = -1;
+    GLint uPointCountHandle = -1;
+    GLint uPointsPerColumnHandle = -1;
+    GLint uHistoryHandle = -1;
+    GLint uViewportHandle = -1;
+    GLint uHalfWidthHandle = -1;
+
+    float lineWidth = 3.0f;
+    GLfloat viewport[2] = {1.0f, 1.0f};
+
+    int lodLevel = 0;
+    GLsizei tracePoints = SENSOR_HISTORY_LENGTH;
+    GLsizei traceVertices = SENSOR_HISTORY_LENGTH * 2;
+
+    SegmentVertex segmentVertices[TRACE_COUNT * MAX_TRACE_VERTICES];
+    // One trace's vertex values (ES2), or every trace's envelope (ES3).
+    GLfloat traceStaging[TRACE_COUNT * MAX_TRACE_POINTS];
+
+    // ES2 path: static segment attributes, and per-vertex sensor values kept
+    // in sync with new samples only for raw history, orphaned and refilled
+    // each frame for the min/max envelope.
+    GLuint segmentBuffer = 0;
+    GLuint valueBuffer = 0;
+
+    // ES3 path: history in a R32F texture, one row per trace and one texel
+    // per ring slot or envelope point.
+    bool historyTextureAllowed = true;
+    bool useHistoryTexture = false;
+    GLuint historyTexture = 0;
+
+    uint64_t accelUploaded = 0;
+    uint64_t gyroUploaded = 0;
+    uint64_t proxUploaded = 0;
+
+    Stats renderStats;
+};
@@ -0,0 +1,132 @@
+#include "unison_oscillator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "simd.h"
+
+namespace {
+
+// Removes the step of a saw wrapping at phase 0 / 1 (two-sample polynomial
+// band-limited step), so the saw doesn't alias audibly at high pitches.
+inline float4 polyBlep4(float4 ph, float4 inc, float4 inverseInc) {
+    float4 t = ph * inverseInc;
+    float4 early = t + t - t * t - 1.0f;         // just after the wrap
+    float4 u = (ph - 1.0f) * inverseInc;
+    float4 late = u * u + u + u + 1.0f;          // just before it
+    return select4(ph < inc, early, select4(ph > 1.0f - inc, late, splat4(0.0f)));
+}
+
+template<int Wave>
+void renderLanes(float *phase, const float *increment, const float *inverseIncrement,
+                 const float *panLeft, const float *panRight, int lanes,
+                 float4 *mixLeft, float4 *mixRight, int frameCount) {
+    for (int g = 0; g < lanes; g += 4) {
+        float4 ph = load4(phase + g);
+        float4 inc = load4(increment + g);
+        float4 inverseInc = load4(inverseIncrement + g);
+        float4 left = load4(panLeft + g);
+        float4 right = load4(panRight + g);
+        for (int f = 0; f < frameCount; f++) {
+            float4 osc;
+            if (Wave == UNISON_WAVE_SINE) {
+                osc = sinTurns4(ph);
+            } else {
+                osc = ph + ph - 1.0f - polyBlep4(ph, inc, inverseInc);
+            }
+            ph += inc;
+            ph = select4(ph >= 1.0f, ph - 1.0f, ph);
+            mixLeft[f] += osc * left;
+            mixRight[f] += osc * right;
+        }
+        store4(phase + g, ph);
+    }
+}
+
+} // namespace
+
+UnisonOscillator::UnisonOscillator() {
+    setVoices(1);
+}
+
+void UnisonOscillator::setSampleRate(float sampleRate) {
+    rate = sampleRate;
+    reset();
+}
+
+void UnisonOscillator::setVoices(int count) {
+    voiceCount = std::clamp(count, 1, MAX_UNISON_VOICES);
+    for (int v = 0; v < MAX_UNISON_VOICES; v++) {
+        bool live = v < voiceCount;
+        position[v] = live && voiceCount > 1 ? 2.0f * float(v) / float(voiceCount - 1) - 1.0f : 0.0f;
+        level[v] = live ? 1.0f / std::sqrt(float(voiceCount)) : 0.0f;
+        increment[v] = 0.0f;
+        inverseIncrement[v] = 0.0f;
+        panLeft[v] = 0.0f;
+        panRight[v] = 0.0f;
+    }
+    reset();
+}
+
+void UnisonOscillator::setWave(int value) {
+    wave = value;
+}
+
+void UnisonOscillator::reset() {
+    // Copies start spread around the cycle (golden-ratio steps) rather than
+    // in phase, which would sound like one loud voice until they drift apart.
+    for (int v = 0; v < MAX_UNISON_VOICES; v++) {
+        float p = 0.618034f * float(v);
+        phase[v] = p - std::floor(p);
+    }
+}
+
+void UnisonOscillator::set(float frequency, float detune, float spread) {
+    frequency = std::min(std::fabs(frequency), 0.5f * rate);
+    detune = std::clamp(detune, 0.0f, 1.0f);
+    spread = std::clamp(spread, 0.0f, 1.0f);
+    // Runs every block, so this is lane-parallel too. 2^(cents / 1200) as a
+    // cubic in x = cents * ln2 / 1200 (|x| <= 0.03, error < 0.01 cent);
+    // pan angle in turns, 0 .. 1/4.
+    const float4 x = splat4(detune * UNISON_MAX_DETUNE_CENTS * 0.6931472f / 1200.0f);
+    const float4 baseIncrement = splat4(frequency / rate);
+    for (int g = 0; g < voiceCount; g += 4) {
+        float4 pos = load4(position + g);
+        float4 lv = load4(level + g);
+        float4 xv = x * pos;
+        float4 ratio = 1.0f + xv * (1.0f + xv * (0.5f + xv * (1.0f / 6.0f)));
+        float4 inc = select4(lv > 0.0f, min4(baseIncrement * ratio, splat4(0.5f)), splat4(0.0f));
+        float4 turns = 0.125f * (spread * pos + 1.0f);
+        store4(increment + g, inc);
+        store4(inverseIncrement + g, select4(inc > 0.0f, 1.0f / inc, splat4(0.0f)));
+        store4(panLeft + g, lv * sinTurns4(turns + 0.25f));
+        store4(panRight + g, lv * sinTurns4(turns));
+    }
+}
+
+void UnisonOscillator::render(float *out, int frameCount, float gainFrom, float gainTo) {
+    assert(frameCount <= DSP_BLOCK_FRAMES);
+    float4 mixLeft[DSP_BLOCK_FRAMES];
+    float4 mixRight[DSP_BLOCK_FRAMES];
+    for (int f = 0; f < frameCount; f++) {
+        mixLeft[f] = splat4(0.0f);
+        mixRight[f] = splat4(0.0f);
+    }
+
+    const int lanes = (voiceCount + 3) & ~3;
+    if (wave == UNISON_WAVE_SINE) {
+        renderLanes<UNISON_WAVE_SINE>(phase, increment, inverseIncrement, panLeft, panRight,
+                                      lanes, mixLeft, mixRight, frameCount);
+    } else {
+        renderLanes<UNISON_WAVE_SAW>(phase, increment, inverseIncrement, panLeft, panRight,
+                                     lanes, mixLeft, mixRight, frameCount);
+    }
+
+    const float step = (gainTo - gainFrom) / float(std::max(frameCount, 1));
+    for (int f = 0; f < frameCount; f++) {
+        float gain = gainFrom + step * float(f + 1);
+        out[2 * f] += gain * hsum4(mixLeft[f]);
+        out[2 * f + 1] += gain * hsum4(mixRight[f]);
+    }
+}
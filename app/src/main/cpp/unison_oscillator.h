@@ -0,0 +1,60 @@
+#pragma once
+
+#include "block_adapter.h"
+
+const int MAX_UNISON_VOICES = 16;               // multiple of 4
+const float UNISON_MAX_DETUNE_CENTS = 50.0f;    // outermost copy at detune 1
+
+const int UNISON_WAVE_SINE = 0;
+const int UNISON_WAVE_SAW = 1;  // PolyBLEP band-limited; a supersaw with several voices
+
+/*
+ * UnisonOscillator
+ *    One tone made of 1..MAX_UNISON_VOICES copies of an oscillator, spread
+ *    evenly in pitch (detune) and across the stereo field (spread) around
+ *    the centre frequency. Each copy is a lane in aligned per-voice arrays
+ *    and render() runs all of them as float4 lanes in one loop, so N copies
+ *    cost about N / 4 oscillators. Output is scaled by 1 / sqrt(N) so the
+ *    level stays roughly the same as voices are added.
+ *
+ *    setVoices() / setWave() / setSampleRate() while the device is
+ *    stopped; set() and render() on the audio thread.
+ */
+class UnisonOscillator {
+public:
+    UnisonOscillator();
+
+    void setSampleRate(float sampleRate);
+
+    // Clamped to 1..MAX_UNISON_VOICES.
+    void setVoices(int count);
+
+    void setWave(int wave);
+
+    // Restarts every copy at its initial phase.
+    void reset();
+
+    // detune and spread are 0..1; detune 1 puts the outer copies
+    // UNISON_MAX_DETUNE_CENTS either side of frequency, spread 1 hard left / right.
+    void set(float frequency, float detune, float spread);
+
+    // Adds frameCount (<= DSP_BLOCK_FRAMES) interleaved stereo frames to
+    // out, scaled by a gain moving linearly from gainFrom to gainTo.
+    void render(float *out, int frameCount, float gainFrom, float gainTo);
+
+    int voices() const { return voiceCount; }
+
+private:
+    float rate = 48000.0f;
+    int voiceCount = 1;
+    int wave = UNISON_WAVE_SAW;
+
+    // Per-copy state; lanes past voiceCount have zero level, increment and pan.
+    alignas(16) float position[MAX_UNISON_VOICES]; // -1 .. 1 across the stack
+    alignas(16) float level[MAX_UNISON_VOICES];    // 1 / sqrt(voiceCount)
+    alignas(16) float phase[MAX_UNISON_VOICES];
+    alignas(16) float increment[MAX_UNISON_VOICES];
+    alignas(16) float inverseIncrement[MAX_UNISON_VOICES];
+    alignas(16) float panLeft[MAX_UNISON_VOICES];
+    alignas(16) float panRight[MAX_UNISON_VOICES];
+};
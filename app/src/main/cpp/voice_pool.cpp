@@ -0,0 +1,189 @@
+#include "voice_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "simd.h"
+
+namespace {
+
+const float MAX_FEEDBACK = 0.2f;          // turns of phase modulation at brightness 1
+const float LOWPASS_MIN_HARMONIC = 2.0f;  // cutoff / frequency at brightness 0
+const float LOWPASS_MAX_HARMONIC = 24.0f; // ... and at brightness 1
+
+} // namespace
+
+VoicePool::VoicePool() {
+    reset();
+}
+
+void VoicePool::setSampleRate(float sampleRate) {
+    rate = sampleRate;
+    reset();
+}
+
+void VoicePool::reset() {
+    for (int v = 0; v < MAX_VOICES; v++) {
+        phase[v] = 0.0f;
+        increment[v] = 0.0f;
+        feedback[v] = 0.0f;
+        previous[v] = 0.0f;
+        gain[v] = 0.0f;
+        envelope[v] = 0.0f;
+        attackStep[v] = 0.0f;
+        releaseFactor[v] = 0.0f;
+        releasing[v] = -1;
+        lowpassCoefficient[v] = 1.0f;
+        lowpassState[v] = 0.0f;
+        panLeft[v] = 0.0f;
+        panRight[v] = 0.0f;
+        busy[v] = false;
+        pinned[v] = false;
+        brightness[v] = 0.0f;
+        holdFrames[v] = -1;
+        serial[v] = 0;
+    }
+    active = 0;
+}
+
+int VoicePool::allocate() {
+    for (int v = 0; v < MAX_VOICES; v++) {
+        if (!busy[v]) return v;
+    }
+    int quietest = -1;
+    int oldest = -1;
+    for (int v = 0; v < MAX_VOICES; v++) {
+        if (pinned[v]) continue;
+        if (releasing[v] && (quietest < 0 || envelope[v] < envelope[quietest])) quietest = v;
+        if (oldest < 0 || nextSerial - serial[v] > nextSerial - serial[oldest]) oldest = v;
+    }
+    int victim = quietest >= 0 ? quietest : oldest;
+    if (victim >= 0) stolen++;
+    return victim;
+}
+
+VoiceId VoicePool::noteOn(const VoiceParams &params, bool pin) {
+    int v = allocate();
+    if (v < 0) return {};
+    if (!busy[v]) {
+        // A fresh voice starts from silence at phase 0; a stolen one keeps
+        // both so the waveform stays continuous.
+        phase[v] = 0.0f;
+        previous[v] = 0.0f;
+        envelope[v] = 0.0f;
+        lowpassState[v] = 0.0f;
+        busy[v] = true;
+        active++;
+    }
+    brightness[v] = std::clamp(params.brightness, 0.0f, 1.0f);
+    tune(v, params.frequency, brightness[v]);
+    gain[v] = params.gain;
+    attackStep[v] = 1.0f / std::max(params.attackSeconds * rate, 1.0f);
+    releaseFactor[v] = std::pow(VOICE_SILENT_LEVEL, 1.0f / std::max(params.releaseSeconds * rate, 1.0f));
+    releasing[v] = 0;
+    const float angle = 0.7853982f * (std::clamp(params.pan, -1.0f, 1.0f) + 1.0f);
+    panLeft[v] = std::cos(angle);
+    panRight[v] = std::sin(angle);
+    holdFrames[v] = params.holdSeconds < 0.0f ? -1 : int64_t(params.holdSeconds * rate);
+    pinned[v] = pin;
+    serial[v] = nextSerial++;
+    return {v, serial[v]};
+}
+
+void VoicePool::tune(int v, float frequency, float bright) {
+    const float nyquist = 0.5f * rate;
+    frequency = std::min(std::fabs(frequency), nyquist);
+    increment[v] = frequency / rate;
+    feedback[v] = MAX_FEEDBACK * bright;
+    float harmonic = LOWPASS_MIN_HARMONIC + (LOWPASS_MAX_HARMONIC - LOWPASS_MIN_HARMONIC) * bright;
+    float cutoff = std::min(frequency * harmonic, 0.45f * rate);
+    lowpassCoefficient[v] = 1.0f - std::exp(-6.2831853f * cutoff / rate);
+}
+
+void VoicePool::release(int v) {
+    releasing[v] = -1;
+    holdFrames[v] = -1;
+}
+
+void VoicePool::retire(int v) {
+    busy[v] = false;
+    pinned[v] = false;
+    gain[v] = 0.0f;
+    envelope[v] = 0.0f;
+    releasing[v] = -1;
+    active--;
+}
+
+void VoicePool::noteOff(VoiceId id) {
+    if (playing(id)) release(id.index);
+}
+
+void VoicePool::setFrequency(VoiceId id, float frequency) {
+    if (playing(id)) tune(id.index, frequency, brightness[id.index]);
+}
+
+void VoicePool::setGain(VoiceId id, float value) {
+    if (playing(id)) gain[id.index] = value;
+}
+
+bool VoicePool::playing(VoiceId id) const {
+    return id.index >= 0 && busy[id.index] && serial[id.index] == id.serial;
+}
+
+void VoicePool::render(float *out, int frameCount) {
+    assert(frameCount <= DSP_BLOCK_FRAMES);
+    if (active == 0) return;
+    float4 mixLeft[DSP_BLOCK_FRAMES];
+    float4 mixRight[DSP_BLOCK_FRAMES];
+    for (int f = 0; f < frameCount; f++) {
+        mixLeft[f] = splat4(0.0f);
+        mixRight[f] = splat4(0.0f);
+    }
+
+    for (int g = 0; g < MAX_VOICES; g += 4) {
+        if (!(busy[g] || busy[g + 1] || busy[g + 2] || busy[g + 3])) continue;
+        float4 ph = load4(phase + g);
+        float4 inc = load4(increment + g);
+        float4 fb = load4(feedback + g);
+        float4 prev = load4(previous + g);
+        float4 amp = load4(gain + g);
+        float4 env = load4(envelope + g);
+        float4 atk = load4(attackStep + g);
+        float4 rel = load4(releaseFactor + g);
+        int4 isReleasing;
+        std::memcpy(&isReleasing, releasing + g, sizeof(isReleasing));
+        float4 lpCoef = load4(lowpassCoefficient + g);
+        float4 lp = load4(lowpassState + g);
+        float4 left = load4(panLeft + g);
+        float4 right = load4(panRight + g);
+        for (int f = 0; f < frameCount; f++) {
+            float4 osc = sinTurns4(fract4(ph + fb * prev));
+            prev = osc;
+            ph += inc;
+            ph = select4(ph >= 1.0f, ph - 1.0f, ph);
+            env = select4(isReleasing, env * rel, min4(env + atk, splat4(1.0f)));
+            lp += lpCoef * (osc * env * amp - lp);
+            mixLeft[f] += lp * left;
+            mixRight[f] += lp * right;
+        }
+        store4(phase + g, ph);
+        store4(previous + g, prev);
+        store4(envelope + g, env);
+        store4(lowpassState + g, lp);
+    }
+
+    for (int f = 0; f < frameCount; f++) {
+        out[2 * f] += hsum4(mixLeft[f]);
+        out[2 * f + 1] += hsum4(mixRight[f]);
+    }
+
+    for (int v = 0; v < MAX_VOICES; v++) {
+        if (!busy[v]) continue;
+        if (holdFrames[v] >= 0) {
+            holdFrames[v] -= frameCount;
+            if (holdFrames[v] <= 0) release(v);
+        }
+        if (releasing[v] && envelope[v] < VOICE_SILENT_LEVEL) retire(v);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+
+#include "block_adapter.h"
+
+const int MAX_VOICES = 32;                 // multiple of 4
+const float VOICE_SILENT_LEVEL = 1e-4f;    // a released voice is freed below this level
+
+struct VoiceParams {
+    float frequency = 220.0f;    // Hz
+    float gain = 0.2f;           // peak level
+    float pan = 0.0f;            // -1 left .. 1 right, constant power
+    float brightness = 0.0f;     // 0 pure sine .. 1 bright (feedback FM, low-pass opened up)
+    float attackSeconds = 0.005f;
+    float releaseSeconds = 0.3f;
+    float holdSeconds = -1.0f;   // released automatically after this; < 0 holds until noteOff()
+};
+
+// A voice handle; stale once the voice is freed or stolen, after which
+// calls with it are ignored.
+struct VoiceId {
+    int index = -1;
+    uint32_t serial = 0;
+};
+
+/*
+ * VoicePool
+ *    Fixed pool of MAX_VOICES voices (feedback-FM sine oscillator, linear
+ *    attack / exponential release envelope, one-pole low-pass, pan) with
+ *    every per-voice value in its own aligned array. render() runs the
+ *    voices four at a time as float4 lanes across a block, skipping groups
+ *    of four with nothing playing, so the cost is proportional to the
+ *    number of active groups and has no per-voice branches.
+ *
+ *    When every voice is busy noteOn() steals, deterministically: the
+ *    quietest releasing voice, else the oldest unpinned one (lowest index
+ *    on ties); pinned voices are never stolen. A stolen voice keeps its
+ *    phase and level and re-attacks from there, so stealing doesn't click.
+ *
+ *    Nothing allocates after construction. Audio thread only, except
+ *    setSampleRate() / reset() while the device is stopped.
+ */
+class VoicePool {
+public:
+    VoicePool();
+
+    void setSampleRate(float sampleRate);
+
+    // Silences and frees every voice.
+    void reset();
+
+    // Invalid id (index -1) when every voice is pinned.
+    VoiceId noteOn(const VoiceParams &params, bool pinned = false);
+
+    void noteOff(VoiceId id);
+
+    void setFrequency(VoiceId id, float frequency);
+
+    void setGain(VoiceId id, float gain);
+
+    bool playing(VoiceId id) const;
+
+    // Adds frameCount (<= DSP_BLOCK_FRAMES) interleaved stereo frames to out.
+    void render(float *out, int frameCount);
+
+    int activeVoices() const { return active; }
+
+    uint64_t voicesStolen() const { return stolen; }
+
+private:
+    int allocate();
+    void tune(int v, float frequency, float brightness);
+    void release(int v);
+    void retire(int v);
+
+    float rate = 48000.0f;
+
+    // Per-voice state, read four lanes at a time by render().
+    alignas(16) float phase[MAX_VOICES];
+    alignas(16) float increment[MAX_VOICES];
+    alignas(16) float feedback[MAX_VOICES];
+    alignas(16) float previous[MAX_VOICES];
+    alignas(16) float gain[MAX_VOICES];
+    alignas(16) float envelope[MAX_VOICES];
+    alignas(16) float attackStep[MAX_VOICES];
+    alignas(16) float releaseFactor[MAX_VOICES];
+    alignas(16) int32_t releasing[MAX_VOICES]; // all ones while releasing or free
+    alignas(16) float lowpassCoefficient[MAX_VOICES];
+    alignas(16) float lowpassState[MAX_VOICES];
+    alignas(16) float panLeft[MAX_VOICES];
+    alignas(16) float panRight[MAX_VOICES];
+
+    // Bookkeeping, touched once per voice per block.
+    bool busy[MAX_VOICES];
+    bool pinned[MAX_VOICES];
+    float brightness[MAX_VOICES];
+    int64_t holdFrames[MAX_VOICES]; // < 0: until noteOff()
+    uint32_t serial[MAX_VOICES];
+    uint32_t nextSerial = 1;
+    int active = 0;
+    uint64_t stolen = 0;
+};
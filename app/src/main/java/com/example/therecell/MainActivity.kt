@@ -2,8 +2,13 @@ package com.example.therecell
 
 import androidx.appcompat.app.AppCompatActivity
 import android.os.Bundle
+import android.app.ActivityManager
+import android.content.Context
+import android.media.AudioManager
 import android.opengl.GLSurfaceView
+import android.view.Choreographer
 import android.content.res.AssetManager
+import java.io.File
 import javax.microedition.khronos.opengles.GL10
 import javax.microedition.khronos.egl.EGLConfig
 
@@ -12,37 +17,93 @@ class MainActivity : AppCompatActivity() {
 
     companion object {
         init { System.loadLibrary("therecell") }
+
+        // Redraw only when new sensor data arrives, capped at MAX_FRAME_RATE.
+        private const val RENDER_ON_DEMAND = true
+        private const val MAX_FRAME_RATE = 60
+
+        // Spectrum analyzer FFT length (power of two) and hop, in samples.
+        private const val SPECTRUM_FFT_SIZE = 2048
+        private const val SPECTRUM_HOP = 512
+
+        // Sensor trace span: 0 draws the last 128 raw samples (1.28 s); level
+        // k draws min/max envelopes of 128 * 2^k samples, up to 9 (minutes).
+        private const val HISTORY_LOD_LEVEL = 0
+
+        // Audio latency profile (native LATENCY_PROFILE_*): 0 ultra-low,
+        // 1 balanced, 2 power-saving. setLatencyProfile() also switches a
+        // running device.
+        private const val LATENCY_PROFILE = 1
+
+        // Needs a native build with -DTHERECELL_TRACING=ON; written to cacheDir.
+        private const val DUMP_TRACE_ON_PAUSE = false
     }
 
-    private external fun init(assetManager: AssetManager)
+    private external fun init(assetManager: AssetManager, cacheDir: String)
 
+    private external fun setNativeAudioParams(sampleRate: Int, framesPerBuffer: Int)
+    private external fun setLatencyProfile(profile: Int)
     private external fun initAudio()
     private external fun surfaceCreated()
     private external fun surfaceChanged(width: Int, height: Int)
+    private external fun setDisplayDensity(density: Float)
     private external fun drawFrame()
     private external fun pause()
     private external fun resume()
+    private external fun requestFrame(frameTimeNanos: Long): Boolean
+    private external fun setMaxFrameRate(fps: Int)
+    private external fun setSpectrumConfig(fftSize: Int, hop: Int)
+    private external fun setHistoryLodLevel(level: Int)
+    private external fun frameStats(): LongArray
+    private external fun audioStats(): LongArray
+    private external fun dumpTrace(path: String): Boolean
 
     private lateinit var glSurfaceView: GLSurfaceView  // <-- declare it here
 
+    // requestFrame() drains the sensors, so it runs on the GL thread.
+    private val frameCallback = object : Choreographer.FrameCallback {
+        override fun doFrame(frameTimeNanos: Long) {
+            glSurfaceView.queueEvent {
+                if (requestFrame(frameTimeNanos)) glSurfaceView.requestRender()
+            }
+            Choreographer.getInstance().postFrameCallback(this)
+        }
+    }
+
     override fun onCreate(savedInstanceState: Bundle?) {
 
         super.onCreate(savedInstanceState)
         System.loadLibrary("therecell")
 
+        setSpectrumConfig(SPECTRUM_FFT_SIZE, SPECTRUM_HOP)
+        setHistoryLodLevel(HISTORY_LOD_LEVEL)
+        // Run the audio device at the output's native rate and burst size
+        val audioManager = getSystemService(Context.AUDIO_SERVICE) as AudioManager
+        setNativeAudioParams(
+            audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE)?.toIntOrNull() ?: 0,
+            audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_FRAMES_PER_BUFFER)?.toIntOrNull() ?: 0)
+        setLatencyProfile(LATENCY_PROFILE)
         initAudio()  // start sine wave
 
 
         glSurfaceView = GLSurfaceView(this)
-        glSurfaceView.setEGLContextClientVersion(2)
+        // ES 3.0 enables the texture-fetch trace path; native code falls back to ES 2.0
+        val activityManager = getSystemService(Context.ACTIVITY_SERVICE) as ActivityManager
+        val supportsEs3 = activityManager.deviceConfigurationInfo.reqGlEsVersion >= 0x30000
+        glSurfaceView.setEGLContextClientVersion(if (supportsEs3) 3 else 2)
         glSurfaceView.setRenderer(object : GLSurfaceView.Renderer {
             override fun onSurfaceCreated(gl: GL10?, config: EGLConfig?) { surfaceCreated() }
             override fun onSurfaceChanged(gl: GL10?, width: Int, height: Int) { surfaceChanged(width, height) }
             override fun onDrawFrame(gl: GL10?) { drawFrame() }
         })
+        if (RENDER_ON_DEMAND) {
+            glSurfaceView.renderMode = GLSurfaceView.RENDERMODE_WHEN_DIRTY
+            setMaxFrameRate(MAX_FRAME_RATE)
+        }
 
         setContentView(glSurfaceView)  // set the GLSurfaceView as the root view
-        init(assets)
+        init(assets, cacheDir.absolutePath)
+        setDisplayDensity(resources.displayMetrics.density)
 
     }
 
@@ -50,13 +111,16 @@ class MainActivity : AppCompatActivity() {
     override fun onPause() {
         super.onPause()
         glSurfaceView.onPause()  // <- important!
+        if (RENDER_ON_DEMAND) Choreographer.getInstance().removeFrameCallback(frameCallback)
         pause()
+        if (DUMP_TRACE_ON_PAUSE) dumpTrace(File(cacheDir, "trace.json").absolutePath)
     }
 
     override fun onResume() {
         super.onResume()
         glSurfaceView.onResume() // <- important!
         resume()
+        if (RENDER_ON_DEMAND) Choreographer.getInstance().postFrameCallback(frameCallback)
     }
 }
 